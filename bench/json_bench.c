@@ -0,0 +1,148 @@
+#define _POSIX_C_SOURCE 200809L
+#include "http_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ============================================
+   JSON PARSING MICROBENCHMARK
+   ============================================
+   Reads two top-level fields out of a generated JSON document - the
+   work json_decode() does for every API request - and reports
+   throughput in GB/s, for a small body and for a large one.
+
+   "one-pass" is the recursive parser used for small bodies. The
+   other rows are the two-stage parser (structural index, then tape)
+   with each classifier the CPU supports. Both must read the whole
+   document: the fields are at the end, and everything before them
+   is validated.
+
+   The "scan" rows time http_scan_json(), which finds the bytes that
+   need escaping when a string is written, with each implementation:
+   once over the large document (a quote every few bytes, so short
+   runs) and once over clean text (one long run).
+
+   Build and run:  make bench && ./build/json_bench
+   ============================================ */
+
+#define LARGE_USERS 2000
+
+#define BENCH_FIELDS(X, S)     \
+    X(S, JSON_INT,    count)   \
+    X(S, JSON_STRING, name)
+JSON_SCHEMA(BenchFields, BENCH_FIELDS);
+#define TARGET_BYTES (256 * 1024 * 1024)  // Parsed per row
+#define CLEAN_TEXT_BYTES (64 * 1024)
+
+// {"users":[...],"count":N,"name":"bench"}, with escapes, UTF-8 and
+// nesting in the user records like a real API payload
+static char *make_document(int users, size_t *length) {
+    size_t capacity = (size_t)users * 400 + 256;
+    char *doc = malloc(capacity);
+    if (!doc) return NULL;
+
+    size_t n = (size_t)snprintf(doc, capacity, "{\"users\":[");
+    for (int i = 0; i < users; i++) {
+        n += (size_t)snprintf(doc + n, capacity - n,
+            "%s{\"id\":%d,\"name\":\"User %d\",\"email\":\"user%d@example.com\","
+            "\"score\":%d.%02d,\"active\":%s,\"tags\":[\"a\",\"b\\u00e9\",\"caf\xc3\xa9\"],"
+            "\"bio\":\"Says \\\"hello\\\" a lot.\\nLikes JSON, C and \xe2\x98\x95 (coffee).\","
+            "\"address\":{\"city\":\"Berlin\",\"zip\":\"10115\",\"geo\":[52.52,13.405]}}",
+            i ? "," : "", i, i, i, i % 100, i % 97, i % 3 ? "true" : "false");
+    }
+    n += (size_t)snprintf(doc + n, capacity - n, "],\"count\":%d,\"name\":\"bench\"}", users);
+    *length = n;
+    return doc;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Seconds per parse; -1 if the fields did not come out right
+static double time_parse(Arena *arena, HttpStr doc, long long expected_count) {
+    int iterations = (int)(TARGET_BYTES / doc.len) + 1;
+    double start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        BenchFields fields;
+        if (json_decode(arena, doc, &BenchFields_schema, &fields) < 0 ||
+            fields.count != expected_count || !fields.name) {
+            return -1;
+        }
+        arena_reset(arena);
+    }
+    return (now_seconds() - start) / iterations;
+}
+
+// Seconds per pass over text, stopping at every byte that needs
+// escaping and carrying on after it, as jw_string() does
+static double time_scan(HttpStr text) {
+    int iterations = (int)(TARGET_BYTES / text.len) + 1;
+    double start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        const char *p = text.ptr;
+        const char *end = p + text.len;
+        while ((p = http_scan_json(p, end)) < end) p++;
+    }
+    return (now_seconds() - start) / iterations;
+}
+
+static void report(const char *name, const HttpStr *docs, const double *seconds, int count) {
+    printf("%-13s", name);
+    for (int i = 0; i < count; i++) {
+        if (seconds[i] < 0) printf("  %8s %10s", "FAILED", "");
+        else printf("  %6.2f GB/s %7.1f us", docs[i].len / seconds[i] / 1e9, seconds[i] * 1e6);
+    }
+    printf("\n");
+}
+
+int main(void) {
+    const int users[2] = {3, LARGE_USERS};
+    HttpStr docs[2];
+    for (int i = 0; i < 2; i++) {
+        size_t length;
+        char *doc = make_document(users[i], &length);
+        if (!doc) return 1;
+        docs[i] = (HttpStr){doc, length};
+    }
+    printf("Documents: %zu and %zu bytes\n\n", docs[0].len, docs[1].len);
+
+    Arena arena = {0};
+    double seconds[2];
+
+    json_index_min_bytes = (size_t)-1;
+    for (int i = 0; i < 2; i++) seconds[i] = time_parse(&arena, docs[i], users[i]);
+    report("one-pass", docs, seconds, 2);
+
+    json_index_min_bytes = 0;
+    HttpScanImpl best = http_scan_best();
+    for (int impl = HTTP_SCAN_SCALAR; impl <= (int)best; impl++) {
+        http_scan_select((HttpScanImpl)impl);
+        for (int i = 0; i < 2; i++) seconds[i] = time_parse(&arena, docs[i], users[i]);
+        char name[32];
+        snprintf(name, sizeof(name), "index/%s", http_scan_name((HttpScanImpl)impl));
+        report(name, docs, seconds, 2);
+    }
+
+    size_t clean_length = CLEAN_TEXT_BYTES;
+    char *clean = malloc(clean_length);
+    if (!clean) return 1;
+    for (size_t i = 0; i < clean_length; i++) clean[i] = "Plain text, no escapes. "[i % 24];
+    HttpStr texts[2] = {docs[1], {clean, clean_length}};
+    printf("\nEscape scan: the large document, then %zu bytes of clean text\n\n", clean_length);
+
+    for (int impl = HTTP_SCAN_SCALAR; impl <= (int)best; impl++) {
+        http_scan_select((HttpScanImpl)impl);
+        for (int i = 0; i < 2; i++) seconds[i] = time_scan(texts[i]);
+        char name[32];
+        snprintf(name, sizeof(name), "scan/%s", http_scan_name((HttpScanImpl)impl));
+        report(name, texts, seconds, 2);
+    }
+
+    free(clean);
+    for (int i = 0; i < 2; i++) free((char *)docs[i].ptr);
+    return 0;
+}
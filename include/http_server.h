@@ -2,6 +2,10 @@
 #define HTTP_SERVER_H
 
 #include <stddef.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
 /* ============================================
    HTTP Server - Core Declarations
@@ -14,47 +18,659 @@ typedef enum {
     HTTP_UNKNOWN
 } HttpMethod;
 
+// A view of bytes owned by someone else: not NUL-terminated, not freed.
+// Print with printf("%.*s", (int)s.len, s.ptr).
+typedef struct {
+    const char *ptr;
+    size_t len;
+} HttpStr;
+
+// Request headers the server knows by name. The parser tags each
+// header with its id, so handlers look one up with an array index
+// instead of comparing names: http_request_header(req, HDR_HOST).
+typedef enum {
+    HDR_UNKNOWN = 0,
+    HDR_ACCEPT,
+    HDR_ACCEPT_CHARSET,
+    HDR_ACCEPT_ENCODING,
+    HDR_ACCEPT_LANGUAGE,
+    HDR_AUTHORIZATION,
+    HDR_CACHE_CONTROL,
+    HDR_CONNECTION,
+    HDR_CONTENT_ENCODING,
+    HDR_CONTENT_LENGTH,
+    HDR_CONTENT_TYPE,
+    HDR_COOKIE,
+    HDR_DATE,
+    HDR_EXPECT,
+    HDR_FORWARDED,
+    HDR_FROM,
+    HDR_HOST,
+    HDR_IF_MATCH,
+    HDR_IF_MODIFIED_SINCE,
+    HDR_IF_NONE_MATCH,
+    HDR_IF_RANGE,
+    HDR_IF_UNMODIFIED_SINCE,
+    HDR_KEEP_ALIVE,
+    HDR_ORIGIN,
+    HDR_PRAGMA,
+    HDR_RANGE,
+    HDR_REFERER,
+    HDR_TE,
+    HDR_TRANSFER_ENCODING,
+    HDR_UPGRADE,
+    HDR_USER_AGENT,
+    HDR_VIA,
+    HDR_X_FORWARDED_FOR,
+    HDR_X_FORWARDED_PROTO,
+    HDR_X_REAL_IP,
+    HDR_X_REQUESTED_WITH,
+    HDR_COUNT
+} HttpHeaderId;
+
+#define HTTP_INLINE_HEADERS 16   // Stored in the request itself
+#define HTTP_MAX_HEADERS 100     // More than this is answered with 431
+
+typedef struct {
+    HttpStr name;
+    HttpStr value;
+    HttpHeaderId id;    // HDR_UNKNOWN for headers not in the table
+} HttpHeader;
+
+typedef struct Arena Arena;
+
 // HTTP Request Structure
+// Every HttpStr points into the connection's receive buffer, so the
+// request is only valid until the handler returns.
 typedef struct {
     HttpMethod method;
-    char path[256];
-    char content_type[128];
-    char *body;
-    size_t body_length;
+    HttpStr method_name;  // As sent, e.g. "GET"
+    int http_minor;   // 0 for HTTP/1.0, 1 for HTTP/1.1
+    int keep_alive;   // Client wants the connection kept open afterwards
+    HttpStr path;     // "/api/users" - without the query string
+    HttpStr query;    // "id=3" for "/api/users?id=3", empty if none
+
+    // All headers in arrival order: the first HTTP_INLINE_HEADERS here,
+    // the rest in extra_headers (heap, rare). Use http_request_header_at().
+    HttpHeader headers[HTTP_INLINE_HEADERS];
+    HttpHeader *extra_headers;
+    size_t extra_capacity;
+    size_t header_count;
+    unsigned char known[HDR_COUNT];  // 1 + index of the first header with that id, 0 = absent
+
+    HttpStr body;
     char client_ip[46];  // IPv6 max length
+
+    // Scratch memory for the handler: everything allocated from it is
+    // released at once after the response is sent (see arena_alloc())
+    Arena *arena;
 } HttpRequest;
 
+/**
+ * Value of a well-known header, in O(1)
+ * @return The first such header's value, or {NULL, 0} if it was not sent
+ */
+HttpStr http_request_header(const HttpRequest *request, HttpHeaderId id);
+
+/**
+ * The i-th header as received (0 <= i < request->header_count)
+ */
+const HttpHeader *http_request_header_at(const HttpRequest *request, size_t i);
+
+/**
+ * Append a header, tagging it with its id
+ * @return 0, or -1 if the request already has HTTP_MAX_HEADERS headers
+ */
+int http_request_add_header(HttpRequest *request, HttpStr name, HttpStr value);
+
+/**
+ * Map a header name to its id (case-insensitive)
+ * @return The id, or HDR_UNKNOWN
+ */
+HttpHeaderId http_header_id(const char *name, size_t len);
+
+/**
+ * Forget a finished request and free anything it allocated, ready for
+ * the next request on the same connection
+ */
+void http_request_reset(HttpRequest *request);
+
+typedef struct CachedFile CachedFile;
+
+// A complete response (status line, headers and body) serialized once
+// at startup, for routes whose output never changes. Sent as-is.
+typedef struct {
+    char *keep_alive;   // With "Connection: keep-alive"
+    size_t keep_alive_length;
+    char *close;        // With "Connection: close"
+    size_t close_length;
+} PrerenderedResponse;
+
+// A reference-counted byte buffer, for bodies several responses send
+// at once (a cached compressed page). Not atomic: only ever shared
+// between the connections of one worker thread.
+typedef struct {
+    int refs;
+    size_t length;
+    char data[];
+} SharedBuffer;
+
+// Who owns HttpResponse.body, and so what happens to it once sent
+typedef enum {
+    BODY_OWNED,     // malloc()ed for this response: freed (the default)
+    BODY_STATIC,    // Lives as long as the program (literal, asset): left alone
+    BODY_SHARED,    // Inside body_shared: one reference released
+    BODY_ARENA,     // From request->arena: reclaimed with it
+    BODY_FILE       // No memory body: body_fd is sent with sendfile()
+} HttpBodyMode;
+
+// Collects the pieces of a streamed body (see http_response_stream()).
+// Fill it with http_writer_write() / http_writer_printf().
+typedef struct {
+    char *buffer;       // Room for the chunk-size line in front of the data
+    size_t length;      // Bytes used, that reserved front included
+    size_t capacity;
+    int failed;         // Out of memory: the stream is aborted
+    Arena *arena;       // buffer lives here, reused for every piece
+} HttpWriter;
+
+// Write the next piece of a streamed body. Called once right after the
+// headers are queued, then again each time the previous piece has left.
+// Returns 1 if more is to come, 0 once the body is complete, -1 to abort.
+typedef int (*HttpStreamFn)(HttpWriter *writer, void *state);
+
+// One byte range of a file body
+typedef struct {
+    off_t offset;
+    size_t length;
+} HttpRange;
+
 // HTTP Response Structure
+// The body is either memory (body, owned as body_mode says) or a range
+// of an open file (BODY_FILE, body_fd), which is sent with sendfile()
+// without ever being read into user space. body_length applies to both.
 typedef struct {
     int status_code;
     char content_type[128];
+    char headers[512];  // Extra header lines, each ending in "\r\n"
     char *body;
     size_t body_length;
+    HttpBodyMode body_mode;
+    SharedBuffer *body_shared;  // BODY_SHARED: the buffer body points into
+    // The body is the same for every request (set for static bodies;
+    // a handler may set it for a generated one): its compressed form may
+    // be kept and reused
+    int body_cacheable;
+    int body_fd;        // File to send the body from, or -1
+    off_t body_offset;  // Where in body_fd the body starts
+    CachedFile *body_file;  // If set, body_fd belongs to this cache entry
+    // Several ranges of body_file, sent as a multipart/byteranges body
+    // (malloc()ed; body_offset/body_length are unused then)
+    HttpRange *ranges;
+    size_t range_count;
+    // If set, every other field is ignored and these bytes are sent
+    const PrerenderedResponse *prerendered;
+    // If set, the body is produced piece by piece while it is being
+    // sent (Transfer-Encoding: chunked) instead of from body/body_fd
+    HttpStreamFn stream;
+    void *stream_state;   // From request->arena (or NULL); kept until the stream ends
 } HttpResponse;
 
+/* ============================================
+   Incremental Request Parser
+   ============================================ */
+
+#define BUFFER_SIZE 65536                    // Slack for pipelined bytes past one request
+#define MAX_HEADER_SIZE 65536                // Request line + headers
+#define MAX_URI_SIZE 8192                    // Longest accepted request target
+#define MAX_BODY_SIZE (8 * 1024 * 1024)      // Largest accepted Content-Length
+
+typedef enum {
+    HTTP_PARSE_NEED_MORE,   // Request incomplete - feed it more bytes later
+    HTTP_PARSE_COMPLETE,    // Request filled in; parser.pos = its length in bytes
+    HTTP_PARSE_ERROR        // Malformed; parser.error_status says how to answer
+} HttpParseStatus;
+
+typedef enum {
+    PARSE_REQUEST_LINE,
+    PARSE_HEADERS,
+    PARSE_BODY,
+    PARSE_DONE
+} HttpParserState;
+
+// Where the parser stopped, so the next call resumes instead of rescanning
+typedef struct {
+    HttpParserState state;
+    size_t pos;             // Bytes already examined
+    size_t line_start;      // Start of the line currently being collected
+    size_t delim;           // First ':' (header) or ' ' (request line) in the current line, 0 = none yet
+    size_t body_start;      // Offset of the first body byte
+    size_t content_length;
+    int has_content_length; // Seen once: a repeat must agree
+    int error_status;       // 400, 413, ... when HTTP_PARSE_ERROR is returned
+    const char *base;       // Buffer the request's views currently point into
+} HttpParser;
+
+/**
+ * Reset a parser to expect the start of a new request
+ */
+void http_parser_init(HttpParser *parser);
+
+/**
+ * Advance the parser over a growing buffer holding one request.
+ * Call again with the same (or a longer) buffer when more bytes arrive;
+ * only the bytes past parser->pos are examined. The buffer may have moved
+ * in between (realloc, memmove): views already stored in the request are
+ * re-pointed at the new copy.
+ * @param parser Parser state from the previous call
+ * @param request Filled in as the request line, headers and body complete
+ * @param data Start of the request
+ * @param length Bytes available so far
+ * @return NEED_MORE, COMPLETE or ERROR
+ */
+HttpParseStatus http_parser_execute(HttpParser *parser, HttpRequest *request,
+                                    const char *data, size_t length);
+
+/* ============================================
+   Delimiter Scanning (SIMD with scalar fallback)
+   ============================================ */
+
+typedef enum {
+    HTTP_SCAN_SCALAR,
+    HTTP_SCAN_SSE42,
+    HTTP_SCAN_AVX2
+} HttpScanImpl;
+
+/**
+ * Find the end of a line and, in the same pass, the first delimiter in it
+ * @param p Where to start scanning
+ * @param end One past the last readable byte
+ * @param delim Byte to look for before the newline, e.g. ':' or ' '
+ * @param first Set to the first delim found before the newline, unless
+ *              it is already non-NULL (so a scan can resume part-way)
+ * @return Pointer to the '\n', or end if the line is not complete yet
+ */
+static inline const char *http_scan_line(const char *p, const char *end, char delim,
+                                         const char **first) {
+    // Lines are short: two passes of the C library's (vectorized)
+    // memchr() beat SIMD code of our own, and even an indirect call
+    const char *newline = memchr(p, '\n', (size_t)(end - p));
+    if (!newline) newline = end;
+    if (!*first) *first = memchr(p, delim, (size_t)(newline - p));
+    return newline;
+}
+
+/**
+ * Find the first byte that must be escaped in a JSON string:
+ * '"', '\\' or a control character below 0x20
+ * @return Pointer to it, or end if the whole run is clean
+ */
+typedef const char *(*HttpScanJsonFn)(const char *p, const char *end);
+extern HttpScanJsonFn http_scan_json;
+
+// One bit per byte of a 64-byte block, bit 0 = first byte
+typedef struct {
+    unsigned long long backslash;   // '\\'
+    unsigned long long quote;       // '"'
+    unsigned long long op;          // { } [ ] : ,
+    unsigned long long whitespace;  // space, \t, \n, \r
+    unsigned long long control;     // Below 0x20
+    unsigned long long high;        // 0x80 and up (non-ASCII UTF-8)
+} JsonBlockMasks;
+
+/**
+ * Classify the 64 bytes at block (all readable) for the JSON
+ * structural index (stage 1 in json_reader.c)
+ */
+typedef void (*HttpScanJsonBlockFn)(const unsigned char *block, JsonBlockMasks *masks);
+extern HttpScanJsonBlockFn http_scan_json_block;
+
+/**
+ * Best implementation this CPU supports (checked with cpuid)
+ */
+HttpScanImpl http_scan_best(void);
+
+/**
+ * Point http_scan_json and http_scan_json_block at an implementation;
+ * capped at http_scan_best().
+ * Not thread-safe: call before starting workers. If never called, the
+ * best one is chosen on first use.
+ * @return The implementation actually selected
+ */
+HttpScanImpl http_scan_select(HttpScanImpl impl);
+
+const char *http_scan_name(HttpScanImpl impl);
+
+/* ============================================
+   Buffer Pool (per thread, size classes 4KB..1MB) and Shared Buffers
+   ============================================ */
+
+/**
+ * Get a buffer of at least `size` bytes, reusing a pooled one if possible
+ * @param capacity Set to the buffer's real size (its size class)
+ * @return The buffer, or NULL if out of memory
+ */
+char *buffer_pool_acquire(size_t size, size_t *capacity);
+
+/**
+ * Give a buffer back to the calling thread's pool (or free it)
+ * @param capacity The capacity buffer_pool_acquire() reported
+ */
+void buffer_pool_release(char *buffer, size_t capacity);
+
+/**
+ * Free every buffer cached by the calling thread (at worker exit)
+ */
+void buffer_pool_trim(void);
+
+/**
+ * Allocate a shared buffer of `length` bytes with one reference
+ * @return The buffer, or NULL if out of memory
+ */
+SharedBuffer *shared_buffer_create(size_t length);
+
+/**
+ * Drop a reference (take one with buffer->refs++); freed with the last
+ */
+void shared_buffer_release(SharedBuffer *buffer);
+
+/* ============================================
+   Request Arena (bump allocator, blocks from the buffer pool)
+   ============================================ */
+
+typedef struct ArenaBlock ArenaBlock;
+
+struct Arena {
+    ArenaBlock *blocks;     // Current block first; NULL until first use
+    void *last;             // Most recent allocation (arena_grow() extends it in place)
+};
+
+/**
+ * Allocate from the arena (16-byte aligned); never freed on its own
+ * @return The memory, or NULL if out of memory
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/**
+ * realloc() for arena memory: extends the most recent allocation in
+ * place when there is room, else copies it into a new one
+ */
+void *arena_grow(Arena *arena, void *ptr, size_t old_size, size_t new_size);
+
+/**
+ * Copy `length` bytes into the arena as a NUL-terminated string
+ */
+char *arena_strndup(Arena *arena, const char *str, size_t length);
+
+/**
+ * sprintf() into the arena
+ * @param length Set to the length of the result (0 on failure)
+ * @return The NUL-terminated string, or NULL if out of memory
+ */
+char *arena_printf(Arena *arena, size_t *length, const char *format, ...);
+
+/**
+ * Release everything allocated from the arena at once, returning its
+ * blocks to the calling thread's buffer pool
+ */
+void arena_reset(Arena *arena);
+
+/* ============================================
+   Connection State
+   ============================================ */
+
+// Hard cap on buffered input: one maximal request plus some pipelined bytes
+#define MAX_READ_BUFFER (MAX_HEADER_SIZE + MAX_BODY_SIZE + BUFFER_SIZE)
+
+#define OUTPUT_IOV_MAX 64   // Segments handed to the kernel per send call
+
+// One piece of a queued response: the status line and headers, or a
+// body. Segments are sent in order, several per system call. A file
+// segment is a range of an open file, handed to sendfile() instead.
+typedef struct {
+    const char *data;   // Next unsent byte
+    size_t length;      // Unsent bytes left
+    void *owned;        // Freed once the segment is sent (NULL = not ours)
+    int fd;             // File to send from, or -1
+    off_t offset;       // Next unsent byte of fd
+    CachedFile *file;   // Owner of fd, released once sent (NULL = close fd)
+    SharedBuffer *shared;   // Holder of data, released once sent (or NULL)
+} OutputSegment;
+
+// One accepted client socket and the bytes queued in each direction.
+// Sockets are non-blocking, so reads and writes may stop part-way and
+// resume on the next readiness event from the event loop.
+typedef struct Connection {
+    int fd;
+    char client_ip[46];
+
+    // Bytes received but not yet consumed by the parser (NUL-terminated).
+    // Borrowed from the buffer pool only while there is unanswered input.
+    char *read_buffer;
+    size_t read_length;
+    size_t read_capacity;
+    int read_full;          // Last read stopped at MAX_READ_BUFFER, not EAGAIN
+
+    // Progress on the request at the front of read_buffer
+    HttpParser parser;
+    HttpRequest request;
+    // Memory for the requests being answered; reset once their
+    // responses have been sent
+    Arena arena;
+
+    // Response segments waiting for the socket to accept them
+    OutputSegment *output;
+    size_t output_head;     // First segment not completely sent
+    size_t output_count;    // Segments queued (sent ones included until drained)
+    size_t output_capacity;
+    size_t output_sent;     // Bytes sent since the queue was last empty
+
+    int close_after_write;  // Close once the output queue has drained
+    // Streamed response body still being produced (see HttpStreamFn)
+    HttpStreamFn stream;
+    void *stream_state;
+    int stream_chunked;     // Chunk framing; 0 = body ends when we close
+    HttpWriter stream_writer;   // Its buffer, reused piece after piece
+    int requests_served;    // Responses queued on this connection so far
+    long long last_active_ms;  // Monotonic time of the last I/O, for idle timeouts
+
+    // io_uring backend: operations still owned by the kernel. The
+    // connection may only be freed once this drops back to zero.
+    int pending_ops;
+    int sending;   // A SENDMSG (or a POLLOUT wait) for the output queue is in flight
+    int closing;
+    // The kernel reads these while that SENDMSG is in flight
+    struct iovec send_iov[OUTPUT_IOV_MAX];
+    struct msghdr send_msg;
+
+    // Intrusive list of live connections owned by the event loop
+    struct Connection *prev;
+    struct Connection *next;
+} Connection;
+
+// An event loop's live connections, least recently active first
+typedef struct {
+    Connection *head;
+    Connection *tail;
+} ConnectionList;
+
+/**
+ * Allocate state for a freshly accepted, non-blocking client socket
+ * @param fd Client socket file descriptor
+ * @param client_ip Printable client address
+ * @return New connection, or NULL on allocation failure
+ */
+Connection *connection_create(int fd, const char *client_ip);
+
+/**
+ * Close the client socket and free all buffered data
+ */
+void connection_destroy(Connection *conn);
+
+/**
+ * Read everything currently available on the socket into read_buffer
+ * @return 1 if the socket is still open, 0 if the peer closed it, -1 on error
+ */
+int connection_read(Connection *conn);
+
+/**
+ * Make room for at least `extra` more bytes in read_buffer
+ * @return 0 on success, -1 if that would exceed MAX_READ_BUFFER
+ */
+int connection_reserve_read(Connection *conn, size_t extra);
+
+/**
+ * Return an empty read_buffer to the pool while the connection is idle
+ */
+void connection_release_read(Connection *conn);
+
+/**
+ * Append a segment to the output queue
+ * @param data Bytes to send; must stay valid until sent
+ * @param owned Freed once the segment has been sent (or on failure);
+ *              NULL if the caller keeps ownership of data
+ * @return 0 on success, -1 if out of memory
+ */
+int connection_queue_output(Connection *conn, const char *data, size_t length, void *owned);
+
+/**
+ * Queue all of a shared buffer for sending
+ * @param buffer Reference handed over to the queue (released once sent)
+ * @return 0, or -1 if out of memory (the reference is released)
+ */
+int connection_queue_shared(Connection *conn, SharedBuffer *buffer);
+
+/**
+ * Append a file segment: `length` bytes of fd starting at `offset`,
+ * sent with sendfile() so they never pass through user space
+ * @param fd Open file
+ * @param file Cache entry that owns fd: the queue releases this
+ *             reference once sent (or on failure). NULL means the
+ *             queue owns fd and closes it instead.
+ * @return 0 on success, -1 if out of memory
+ */
+int connection_queue_file(Connection *conn, int fd, off_t offset, size_t length,
+                          CachedFile *file);
+
+/**
+ * Send the file segment at the head of the output queue with sendfile()
+ * until it is done or the socket fills up
+ * @return 1 when the segment is done, 0 if the socket would block,
+ *         -1 on error
+ */
+int connection_send_file(Connection *conn);
+
+/**
+ * Whether the next segment to send is a file segment
+ */
+int connection_output_is_file(const Connection *conn);
+
+/**
+ * Describe the unsent part of the output queue as an iovec array,
+ * stopping at the first file segment
+ * @return Number of entries filled (at most max)
+ */
+size_t connection_output_iov(const Connection *conn, struct iovec *iov, size_t max);
+
+/**
+ * Write as much of the output queue as the socket will take, gathering
+ * several segments into each sendmsg() call and sending file segments
+ * with sendfile()
+ * @return 1 when fully drained, 0 if the socket would block, -1 on error
+ */
+int connection_flush(Connection *conn);
+
+/**
+ * Whether the connection still has response bytes waiting to be written
+ */
+int connection_has_pending_output(const Connection *conn);
+
+/**
+ * Whether the connection is done and may be closed: it was asked to
+ * close and no streamed body is still being produced
+ */
+int connection_finished(const Connection *conn);
+
+/**
+ * Mark bytes of the output queue as sent, releasing finished segments
+ * @param sent Bytes the socket accepted
+ */
+void connection_advance_output(Connection *conn, size_t sent);
+
+/**
+ * Link/unlink a connection into an event loop's list of live connections
+ */
+void connection_list_add(ConnectionList *list, Connection *conn);
+void connection_list_remove(ConnectionList *list, Connection *conn);
+
+/**
+ * Record activity: stamp last_active_ms and move conn to the list tail,
+ * so the head is always the connection that has been idle longest
+ */
+void connection_list_touch(ConnectionList *list, Connection *conn);
+
+/**
+ * Milliseconds on a monotonic clock (unaffected by wall-clock changes)
+ */
+long long connection_now_ms(void);
+
 /* ============================================
    Server Functions
    ============================================ */
 
+// How worker threads wait for and perform socket I/O
+typedef enum {
+    IO_BACKEND_EPOLL,     // Readiness events + plain recv()/send() syscalls
+    IO_BACKEND_IO_URING   // Completion queue; falls back to epoll if unsupported
+} IoBackend;
+
+// Startup options parsed from the command line
+typedef struct {
+    int port;           // TCP port to listen on
+    int workers;        // Event-loop threads; 0 = one per online CPU
+    IoBackend backend;
+    int keepalive_timeout;  // Seconds a connection may sit idle before we close it
+    int max_requests;       // Requests served on one connection before closing it
+    const char *static_root;    // Directory served under static_prefix
+    const char *static_prefix;  // URL path mounting it, e.g. "/static/"
+} ServerConfig;
+
+// Active configuration, set once by start_http_server() before workers start
+extern ServerConfig server_config;
+
 /**
  * Initialize and start the HTTP server
- * @param port The port number to listen on
+ * @param config Port and worker count
  * @return 0 on success, -1 on failure
  */
-int start_http_server(int port);
+int start_http_server(const ServerConfig *config);
 
 /**
- * Parse raw HTTP request into HttpRequest structure
+ * Serve one worker's listener with io_uring instead of epoll
+ * @param worker_id Worker number (for logging)
+ * @param server_fd Listening socket
+ * @param shutdown_fd eventfd that becomes readable on shutdown
+ * @return 0 after shutdown, -1 if io_uring is unavailable on this kernel
+ *         (nothing was accepted, so the caller can fall back to epoll)
+ */
+int run_io_uring_loop(int worker_id, int server_fd, int shutdown_fd);
+
+/**
+ * Parse a complete raw HTTP request in one go
  * @param raw_request Raw HTTP request string
- * @param request Pointer to HttpRequest structure to fill
+ * @param request Zeroed HttpRequest to fill; its views point into
+ *                raw_request. Release it with http_request_reset().
+ * @return HTTP_PARSE_COMPLETE, or NEED_MORE/ERROR if it is truncated/malformed
  */
-void parse_http_request(const char *raw_request, HttpRequest *request);
+HttpParseStatus parse_http_request(const char *raw_request, HttpRequest *request);
 
 /**
- * Handle incoming client connection
- * @param client_fd Client socket file descriptor
+ * Process a complete request buffered on a connection, if there is one.
+ * Does nothing while an earlier response is still being written, so
+ * callers should call again once the write queue drains.
+ * @param conn Connection whose read_buffer holds the received bytes
  */
-void handle_client_connection(int client_fd);
+void handle_client_connection(Connection *conn);
 
 /**
  * Route request to appropriate handler
@@ -64,20 +680,108 @@ void handle_client_connection(int client_fd);
 void route_request(const HttpRequest *request, HttpResponse *response);
 
 /**
- * Send HTTP response back to client
- * @param client_fd Client socket file descriptor
- * @param response The HTTP response to send
+ * Render the complete responses for every embedded asset once (each
+ * encoding, 200 and 304); call before any worker starts
+ * @return 0 on success, -1 if out of memory
  */
-void send_http_response(int client_fd, const HttpResponse *response);
+int routes_init(void);
 
-/* ============================================
-   Route Handlers
-   ============================================ */
+/**
+ * Free what routes_init() built (after every worker has stopped)
+ */
+void routes_cleanup(void);
+
+/**
+ * Queue an HTTP response on the connection: a header segment plus the
+ * body, sent together once the socket is writable
+ * @param conn Connection to answer
+ * @param response The HTTP response to send. Takes ownership of the
+ *                 malloc()ed body or the body file (response->body is
+ *                 set to NULL, response->body_fd to -1).
+ */
+void send_http_response(Connection *conn, HttpResponse *response);
+
+/**
+ * Serialize a response with an in-memory body (status line, headers
+ * and body) into one malloc()ed buffer
+ * @param close_connection Which Connection header to write
+ * @param length Set to the number of bytes
+ * @return The buffer, or NULL if out of memory
+ */
+char *http_serialize_response(const HttpResponse *response, int close_connection,
+                              size_t *length);
+
+/**
+ * Send a body that outlives the response (a string literal, an
+ * embedded asset) straight from where it is, without a copy
+ */
+void http_response_set_static(HttpResponse *response, const char *body, size_t length);
+
+/**
+ * Send all of a shared buffer as the body
+ * @param buffer Reference handed over to the response
+ */
+void http_response_set_shared(HttpResponse *response, SharedBuffer *buffer);
+
+/**
+ * Let go of the response's memory body as its body_mode says (free,
+ * release or nothing), leaving it without one
+ */
+void http_response_release_body(HttpResponse *response);
+
+/**
+ * Add a header line to the response (dropped, with a warning, if the
+ * response's header space is full)
+ */
+void http_response_add_header(HttpResponse *response, const char *name, const char *value);
+
+/**
+ * Make the response body a stream: `fn` is called to write it piece by
+ * piece as the client takes it, so it never has to exist in memory
+ * all at once. Set status_code and content_type as usual.
+ * @param state Passed to every call. Allocate it from request->arena:
+ *              the arena is kept until the stream has ended.
+ */
+void http_response_stream(HttpResponse *response, HttpStreamFn fn, void *state);
+
+/**
+ * Append bytes to the current piece of a streamed body
+ */
+void http_writer_write(HttpWriter *writer, const char *data, size_t length);
 
 /**
- * GET / - Root endpoint
+ * Append formatted text to the current piece of a streamed body
  */
-void handle_root(const HttpRequest *request, HttpResponse *response);
+void http_writer_printf(HttpWriter *writer, const char *format, ...);
+
+/**
+ * Reason phrase for an HTTP status code
+ * @param status_code e.g. 404
+ * @return e.g. "Not Found"
+ */
+const char *http_status_message(int status_code);
+
+/* ============================================
+   Embedded Assets (generated from assets/ at build time)
+   ============================================ */
+
+// One file from assets/, compiled into the binary by tools/embed_assets.c.
+// Served at "/" + name, minus ".html" ("index.html" is "/").
+typedef struct {
+    const char *name;                 // Path below assets/, e.g. "glossary.html"
+    const unsigned char *data;
+    size_t length;
+    const unsigned char *gzip_data;   // gzip-compressed copy, or NULL if not smaller
+    size_t gzip_length;
+    const char *etag;                 // Quoted hash of data
+} EmbeddedAsset;
+
+extern const EmbeddedAsset embedded_assets[];
+extern const size_t embedded_asset_count;
+
+/* ============================================
+   Route Handlers
+   ============================================ */
 
 /**
  * GET /info - Server information
@@ -89,29 +793,195 @@ void handle_info(const HttpRequest *request, HttpResponse *response);
  */
 void handle_image(const HttpRequest *request, HttpResponse *response);
 
+/* ============================================
+   JSON Schemas (read by src/json_reader.c, written by src/json_writer.c)
+   ============================================ */
+
+typedef enum {
+    JSON_STRING,    // const char *: NUL-terminated, NULL if missing
+    JSON_INT,       // long long: whole numbers that fit only
+    JSON_DOUBLE     // double
+} JsonFieldType;
+
+// One member of a struct bound to a JSON object
+typedef struct {
+    const char *key;
+    const char *fragment;       // ,"key": - written as is, no escaping
+    size_t key_length;
+    size_t fragment_length;
+    JsonFieldType type;
+    size_t offset;              // Of the member in the struct
+} JsonSchemaField;
+
+typedef struct {
+    const JsonSchemaField *fields;
+    size_t count;
+} JsonSchema;
+
+/*
+ * A struct and its JSON binding from one list of members:
+ *
+ *     #define POINT_FIELDS(X, S) \
+ *         X(S, JSON_STRING, label) \
+ *         X(S, JSON_INT,    x)
+ *     JSON_SCHEMA(Point, POINT_FIELDS);
+ *
+ * declares `typedef struct { const char *label; long long x; } Point`
+ * and `Point_schema` for json_decode() and jw_struct(). The member
+ * names are the keys, so they are plain C identifiers: the key
+ * fragments are made by the preprocessor and never need escaping.
+ */
+#define JSON_C_TYPE_JSON_STRING const char *
+#define JSON_C_TYPE_JSON_INT long long
+#define JSON_C_TYPE_JSON_DOUBLE double
+
+#define JSON_SCHEMA_MEMBER(S, type, name) JSON_C_TYPE_##type name;
+#define JSON_SCHEMA_FIELD(S, type, name) \
+    {#name, ",\"" #name "\":", sizeof(#name) - 1, sizeof(#name) + 3, type, offsetof(S, name)},
+
+#define JSON_SCHEMA(S, FIELDS)                                              \
+    typedef struct { FIELDS(JSON_SCHEMA_MEMBER, S) } S;                     \
+    static const JsonSchemaField S##_fields[] = { FIELDS(JSON_SCHEMA_FIELD, S) }; \
+    static const JsonSchema S##_schema = {S##_fields, sizeof(S##_fields) / sizeof(S##_fields[0])}
+
+/* ============================================
+   JSON Writer (see src/json_writer.c)
+   ============================================ */
+
+#define JSON_MAX_DEPTH 64
+
+// Builds one JSON document in an arena. Commas, colons and (in pretty
+// mode) newlines and indentation are written for you:
+//
+//     jw_object_begin(&w);
+//     jw_key(&w, "id");   jw_int(&w, 7);
+//     jw_key(&w, "name"); jw_string(&w, name);
+//     jw_object_end(&w);
+typedef struct {
+    char *buffer;
+    size_t length;
+    size_t capacity;
+    Arena *arena;
+    int pretty;                 // Newlines and two-space indentation
+    int depth;                  // Open objects/arrays
+    unsigned long long filled;  // Bit n: the container at depth n has a member
+    int after_key;              // The next value belongs to a key
+    int failed;                 // Out of memory or nested too deep
+} JsonWriter;
+
+void jw_init(JsonWriter *w, Arena *arena, int pretty);
+void jw_object_begin(JsonWriter *w);
+void jw_object_end(JsonWriter *w);
+void jw_array_begin(JsonWriter *w);
+void jw_array_end(JsonWriter *w);
+void jw_key(JsonWriter *w, const char *key);
+void jw_string(JsonWriter *w, const char *str);
+void jw_string_n(JsonWriter *w, const char *str, size_t length);
+void jw_int(JsonWriter *w, long long value);
+void jw_double(JsonWriter *w, double value);   // NaN and infinity become null
+void jw_bool(JsonWriter *w, int value);
+void jw_null(JsonWriter *w);
+
+/**
+ * A struct as a JSON object, members in declaration order. Compact
+ * output writes each key as its precomputed fragment.
+ */
+void jw_struct(JsonWriter *w, const JsonSchema *schema, const void *value);
+
+/**
+ * NUL-terminate the document and return it (in the arena)
+ * @return NULL if the writer failed or a container is still open
+ */
+char *jw_finish(JsonWriter *w, size_t *length);
+
+/**
+ * Finish the document and make it the response body, as
+ * application/json with the given status (500 if the writer failed)
+ */
+void jw_respond(JsonWriter *w, HttpResponse *response, int status_code);
+
 /**
- * GET /glossary - C language reference
+ * Whether the client asked for indented JSON ("?pretty" in the URL);
+ * API responses are compact otherwise
  */
-void handle_glossary(const HttpRequest *request, HttpResponse *response);
+int json_wants_pretty(const HttpRequest *request);
+
+/* ============================================
+   JSON Reader (see src/json_reader.c)
+   ============================================ */
 
 /**
- * GET /how-it-works - Request/response cycle explanation
+ * Parse a JSON object straight into a struct declared with
+ * JSON_SCHEMA(). Members missing from the body, or of another type,
+ * are left zero (NULL for strings); strings are unescaped into the
+ * arena. Other keys, and everything nested, are checked but not kept.
+ * @return 0, or -1 if the body is not a valid JSON object
  */
-void handle_how_it_works(const HttpRequest *request, HttpResponse *response);
+int json_decode(Arena *arena, HttpStr json, const JsonSchema *schema, void *out);
 
 /**
- * JSON Builder for safe JSON construction
+ * Bodies at least this long are read through the structural index
+ * (json_parse()) instead of the one-pass parser. (size_t)-1 turns the
+ * index off, as the server does when only the scalar classifier exists.
  */
+extern size_t json_index_min_bytes;
+
+typedef enum {
+    JSON_NODE_OBJECT,
+    JSON_NODE_ARRAY,
+    JSON_NODE_STRING,
+    JSON_NODE_NUMBER,
+    JSON_NODE_TRUE,
+    JSON_NODE_FALSE,
+    JSON_NODE_NULL
+} JsonNodeType;
+
+// One value on the tape. A container is followed by its contents -
+// for objects, key (a string node) then value, for each member.
 typedef struct {
-    char *buffer;
-    size_t size;
-    size_t capacity;
-} JSONBuilder;
+    JsonNodeType type;
+    unsigned span;      // Nodes in this value, itself included
+    unsigned count;     // Objects: members, arrays: elements
+    unsigned length;    // Strings and numbers: bytes of text
+    const char *text;   // In the parsed body; strings without the quotes, still escaped
+    int escaped;        // String: has backslash escapes
+    int whole;          // Number: no fraction or exponent
+} JsonNode;
 
-JSONBuilder* json_builder_create(void);
-void json_builder_append(JSONBuilder *jb, const char *str);
-void json_builder_append_escaped(JSONBuilder *jb, const char *str);
-char* json_builder_finalize(JSONBuilder *jb);
+typedef struct {
+    JsonNode *nodes;    // nodes[0] is the document's value; in the arena
+    size_t count;
+} JsonDocument;
+
+/**
+ * Parse and validate (UTF-8 included) a whole JSON document: SIMD
+ * structural index, then a tape of nodes. The nodes point into json,
+ * which must outlive them.
+ * @return 0, or -1 if it is not valid JSON
+ */
+int json_parse(Arena *arena, HttpStr json, JsonDocument *doc);
+
+/**
+ * Value of a member of an object node, NULL if missing (or not an object)
+ */
+const JsonNode *json_object_get(const JsonNode *object, const char *key);
+
+/**
+ * The node after this value and everything inside it: the next element
+ * of an array, or the next key of an object
+ */
+const JsonNode *json_node_next(const JsonNode *node);
+
+/**
+ * A string node unescaped into the arena (NUL-terminated); NULL if not a string
+ */
+char *json_node_string(Arena *arena, const JsonNode *node, size_t *length);
+
+/**
+ * A whole-number node that fits in 64 bits
+ * @return 0, or -1 if it is not one
+ */
+int json_node_int(const JsonNode *node, long long *value);
 
 /**
  * JSON API Endpoints
@@ -123,6 +993,7 @@ void handle_api_stats(const HttpRequest *request, HttpResponse *response);
 void handle_api_login(const HttpRequest *request, HttpResponse *response);
 void handle_api_calculate(const HttpRequest *request, HttpResponse *response);
 void handle_api_time(const HttpRequest *request, HttpResponse *response);
+void handle_api_primes(const HttpRequest *request, HttpResponse *response);
 
 /**
  * External API Client Endpoints (calls other APIs)
@@ -147,17 +1018,129 @@ void handle_post_data(const HttpRequest *request, HttpResponse *response);
  */
 void handle_not_found(const HttpRequest *request, HttpResponse *response);
 
+/* ============================================
+   Static Files (docroot + per-thread open-file cache)
+   ============================================ */
+
+#define FILE_CACHE_ENTRIES 64       // Open files cached per worker thread
+#define FILE_CACHE_VALID_MS 2000    // Re-stat a cached file at most this often
+#define HTTP_MAX_RANGES 16          // More ranges than this: send the whole file
+
+// An open file plus everything a response needs to describe it. Shared
+// by the cache and every response still sending it: the fd stays open
+// until the last reference is released, even if the cache dropped it.
+struct CachedFile {
+    char *path;
+    int fd;
+    size_t size;
+    time_t mtime;
+    dev_t device;
+    ino_t inode;
+    const char *mime_type;
+    char etag[48];            // "\"<mtime hex>-<size hex>\""
+    char last_modified[32];   // HTTP date of mtime
+    int refs;                 // One for the cache, one per user
+    int cached;               // Still findable through the cache
+    long long checked_ms;     // When the file was last stat()ed
+    struct CachedFile *hash_next;
+    struct CachedFile *lru_prev;
+    struct CachedFile *lru_next;
+};
+
+/**
+ * Get an open regular file from the calling thread's cache, opening
+ * and stat()ing it only on a miss or when FILE_CACHE_VALID_MS passed
+ * @param path Filesystem path
+ * @return A new reference (release with file_cache_release()), or NULL
+ *         with errno set (EISDIR for a directory)
+ */
+CachedFile *file_cache_open(const char *path);
+
+/**
+ * Drop a reference; the fd is closed when the last one goes
+ */
+void file_cache_release(CachedFile *file);
+
+/**
+ * Drop every cached file of the calling thread (at worker exit)
+ */
+void file_cache_trim(void);
+
+/**
+ * Answer with a cached file, honouring conditional and Range headers:
+ * 304 Not Modified, 206 Partial Content (one range, or several as
+ * multipart/byteranges), 416 Range Not Satisfiable, or a plain 200
+ * @param file Reference handed over to the response
+ */
+void http_serve_file(const HttpRequest *request, HttpResponse *response, CachedFile *file);
+
+/**
+ * Serve files below server_config.static_root for paths under
+ * server_config.static_prefix, through http_serve_file()
+ */
+void handle_static(const HttpRequest *request, HttpResponse *response);
+
+/* ============================================
+   Response Compression (gzip/deflate, per-thread result cache)
+   ============================================ */
+
+/**
+ * Compress an in-memory body the client accepts gzip or deflate for,
+ * when it is big enough and of a text type. Adds Content-Encoding and
+ * Vary; replaces (and frees) response->body. Repeated bodies are
+ * answered from the calling thread's cache of compressed results.
+ */
+void http_compress_response(const HttpRequest *request, HttpResponse *response);
+
+/**
+ * Drop every cached compressed body of the calling thread (at worker exit)
+ */
+void compress_cache_trim(void);
+
 /* ============================================
    Utility Functions
    ============================================ */
 
 /**
- * Read an image file into memory
- * @param filename Path to image file
- * @param size Pointer to store file size
- * @return Pointer to file data (caller must free)
+ * Compare a string view with a C string
+ * @return 1 if they hold the same bytes (case-sensitive)
+ */
+int http_str_equals(HttpStr str, const char *literal);
+
+/**
+ * Compare a string view with a C string, ignoring ASCII case
+ * (header names are case-insensitive)
+ */
+int http_str_case_equals(HttpStr str, const char *literal);
+
+/**
+ * Whether a string view starts with a C string
+ */
+int http_str_has_prefix(HttpStr str, const char *prefix);
+
+/**
+ * Whether an If-None-Match value ("*" or a list of ETags, weak or
+ * strong) names this ETag
+ */
+int http_etag_matches(HttpStr list, const char *etag);
+
+/**
+ * Whether an Accept-Encoding value allows a content coding
+ * ("gzip", q > 0, directly or through "*")
+ */
+int http_accepts_encoding(HttpStr accept_encoding, const char *coding);
+
+/**
+ * Format a time as an HTTP date ("Sun, 06 Nov 1994 08:49:37 GMT")
+ * @param out At least 30 bytes
+ */
+void http_format_date(time_t t, char *out, size_t size);
+
+/**
+ * Parse an HTTP date (IMF-fixdate, the only format we send)
+ * @return 0 on success, -1 if it is not a valid date
  */
-unsigned char *read_image_file(const char *filename, size_t *size);
+int http_parse_date(HttpStr value, time_t *t);
 
 /**
  * URL decode a string
@@ -8,7 +8,11 @@
 /*
  * PRODUCTION-READY JSON API with proper parsing
  * 
- * This uses a simple but robust JSON builder pattern.
+ * Request bodies are read with the JSON reader (src/json_reader.c),
+ * responses are built with the JSON writer (src/json_writer.c).
+ * The objects that go in and out are C structs bound with
+ * JSON_SCHEMA(): one member list gives the struct, its parser and its
+ * serializer.
  * For REAL production apps, use: cJSON, json-c, or jansson libraries
  * 
  * Install with: sudo apt-get install libjson-c-dev
@@ -16,520 +20,358 @@
  */
 
 // ========================================
-// JSON Builder - Safe and Scalable
+// API Endpoints - Production Ready
 // ========================================
 
-JSONBuilder* json_builder_create(void) {
-    JSONBuilder *jb = malloc(sizeof(JSONBuilder));
-    if (!jb) return NULL;
-    
-    jb->capacity = 4096;
-    jb->buffer = malloc(jb->capacity);
-    if (!jb->buffer) {
-        free(jb);
-        return NULL;
-    }
-    jb->buffer[0] = '\0';
-    jb->size = 0;
-    return jb;
+// {"success": false, "error": message}
+static void send_error(const HttpRequest *request, HttpResponse *response,
+                       int status_code, const char *message) {
+    JsonWriter w;
+    jw_init(&w, request->arena, json_wants_pretty(request));
+    jw_object_begin(&w);
+    jw_key(&w, "success"); jw_bool(&w, 0);
+    jw_key(&w, "error");   jw_string(&w, message);
+    jw_object_end(&w);
+    jw_respond(&w, response, status_code);
 }
 
-void json_builder_append(JSONBuilder *jb, const char *str) {
-    size_t len = strlen(str);
-    
-    // Resize if needed
-    while (jb->size + len + 1 > jb->capacity) {
-        jb->capacity *= 2;
-        char *new_buf = realloc(jb->buffer, jb->capacity);
-        if (!new_buf) return;
-        jb->buffer = new_buf;
-    }
+void handle_api_health(const HttpRequest *request, HttpResponse *response) {
+    time_t now = time(NULL);
+    struct tm tm_buf;
+    struct tm *tm_info = localtime_r(&now, &tm_buf);  // Reentrant: workers run in parallel
+    char timestamp[64];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", tm_info);
     
-    strcat(jb->buffer, str);
-    jb->size += len;
+    JsonWriter w;
+    jw_init(&w, request->arena, json_wants_pretty(request));
+    jw_object_begin(&w);
+    jw_key(&w, "status");         jw_string(&w, "healthy");
+    jw_key(&w, "service");        jw_string(&w, "http-server");
+    jw_key(&w, "version");        jw_string(&w, "1.0.0");
+    jw_key(&w, "timestamp");      jw_string(&w, timestamp);
+    jw_key(&w, "uptime_seconds"); jw_int(&w, (long long)now);
+    jw_object_end(&w);
+    jw_respond(&w, response, 200);
 }
 
-void json_builder_append_escaped(JSONBuilder *jb, const char *str) {
-    // Escape special characters in strings
-    char escaped[2048];
-    size_t j = 0;
-    
-    for (size_t i = 0; str[i] && j < sizeof(escaped) - 2; i++) {
-        switch (str[i]) {
-            case '"':  escaped[j++] = '\\'; escaped[j++] = '"'; break;
-            case '\\': escaped[j++] = '\\'; escaped[j++] = '\\'; break;
-            case '\n': escaped[j++] = '\\'; escaped[j++] = 'n'; break;
-            case '\r': escaped[j++] = '\\'; escaped[j++] = 'r'; break;
-            case '\t': escaped[j++] = '\\'; escaped[j++] = 't'; break;
-            default:   escaped[j++] = str[i]; break;
-        }
-    }
-    escaped[j] = '\0';
-    json_builder_append(jb, escaped);
-}
+// A user as listed by GET /api/users, and as created by POST (which
+// reads the same members from the body; id is ours to set)
+#define USER_FIELDS(X, S)         \
+    X(S, JSON_INT,    id)         \
+    X(S, JSON_STRING, name)       \
+    X(S, JSON_STRING, email)      \
+    X(S, JSON_STRING, role)
+JSON_SCHEMA(User, USER_FIELDS);
+
+#define LOGIN_REQUEST_FIELDS(X, S) \
+    X(S, JSON_STRING, username)    \
+    X(S, JSON_STRING, password)
+JSON_SCHEMA(LoginRequest, LOGIN_REQUEST_FIELDS);
 
-char* json_builder_finalize(JSONBuilder *jb) {
-    char *result = jb->buffer;
-    free(jb);
-    return result;
+#define LOGIN_RESULT_FIELDS(X, S)  \
+    X(S, JSON_STRING, user)        \
+    X(S, JSON_STRING, token)       \
+    X(S, JSON_INT,    expires_in)
+JSON_SCHEMA(LoginResult, LOGIN_RESULT_FIELDS);
+
+// The request is a, b and operation; the answer repeats them with the result
+#define CALCULATION_FIELDS(X, S)   \
+    X(S, JSON_INT,    a)           \
+    X(S, JSON_INT,    b)           \
+    X(S, JSON_STRING, operation)   \
+    X(S, JSON_DOUBLE, result)
+JSON_SCHEMA(Calculation, CALCULATION_FIELDS);
+
+// The user directory (a simulated database)
+static const User users[] = {
+    {1, "Alice Johnson", "alice@example.com", "admin"},
+    {2, "Bob Smith", "bob@example.com", "user"},
+    {3, "Carol White", "carol@example.com", "user"},
+};
+
+#define USER_COUNT (sizeof(users) / sizeof(users[0]))
+
+void handle_api_users_get(const HttpRequest *request, HttpResponse *response) {
+    // A few hundred bytes: built whole and sent with a Content-Length
+    JsonWriter w;
+    jw_init(&w, request->arena, json_wants_pretty(request));
+    jw_object_begin(&w);
+    jw_key(&w, "success"); jw_bool(&w, 1);
+    jw_key(&w, "data");
+    jw_array_begin(&w);
+    for (size_t i = 0; i < USER_COUNT; i++) {
+        jw_struct(&w, &User_schema, &users[i]);
+    }
+    jw_array_end(&w);
+    jw_key(&w, "count");   jw_int(&w, (long long)USER_COUNT);
+    jw_object_end(&w);
+    jw_respond(&w, response, 200);
 }
 
-// ========================================
-// JSON Parser - Robust and Safe
-// ========================================
+// GET /api/primes?limit=N lists every prime up to N. How big the answer
+// is depends on the query - below a million there are 78498 primes,
+// about 550KB of JSON - so it is streamed: produced a batch at a time
+// while it is being sent, in one buffer of about PRIMES_BATCH_BYTES
+// whatever the limit. (A chunk per number would be mostly chunk
+// framing and one send per few bytes.)
+#define PRIMES_DEFAULT_LIMIT 1000
+#define PRIMES_MAX_LIMIT 1000000
+#define PRIMES_BATCH_BYTES 16384
 
 typedef struct {
-    const char *json;
-    size_t pos;
-    size_t length;
-} JSONParser;
+    long long next;     // Next candidate; 0 = nothing written yet
+    long long limit;
+    long long count;    // Primes written so far
+    JsonWriter json;    // One document across all the chunks
+} PrimeStream;
 
-static void skip_whitespace(JSONParser *p) {
-    while (p->pos < p->length && 
-           (p->json[p->pos] == ' ' || p->json[p->pos] == '\n' || 
-            p->json[p->pos] == '\r' || p->json[p->pos] == '\t')) {
-        p->pos++;
+static int is_prime(long long n) {
+    if (n < 2) return 0;
+    if (n % 2 == 0) return n == 2;
+    for (long long d = 3; d * d <= n; d += 2) {
+        if (n % d == 0) return 0;
     }
+    return 1;
 }
 
-static char* json_parse_string(JSONParser *p) {
-    skip_whitespace(p);
-    
-    if (p->pos >= p->length || p->json[p->pos] != '"') {
-        return NULL;
+// Hand what the JSON writer has so far to the stream, and reuse its
+// buffer for the next chunk (the nesting is kept)
+static int flush_json(HttpWriter *writer, JsonWriter *json) {
+    if (json->failed) return -1;
+    http_writer_write(writer, json->buffer, json->length);
+    json->length = 0;
+    return 0;
+}
+
+static int write_primes(HttpWriter *writer, void *state) {
+    PrimeStream *stream = state;
+    JsonWriter *w = &stream->json;
+
+    if (stream->next == 0) {
+        jw_object_begin(w);
+        jw_key(w, "success"); jw_bool(w, 1);
+        jw_key(w, "limit");   jw_int(w, stream->limit);
+        jw_key(w, "data");    jw_array_begin(w);
+        stream->next = 2;
     }
-    p->pos++; // Skip opening quote
-    
-    size_t start = p->pos;
-    while (p->pos < p->length && p->json[p->pos] != '"') {
-        if (p->json[p->pos] == '\\') {
-            p->pos++; // Skip escape char
+    while (stream->next <= stream->limit && w->length < PRIMES_BATCH_BYTES) {
+        if (is_prime(stream->next)) {
+            jw_int(w, stream->next);
+            stream->count++;
         }
-        p->pos++;
+        stream->next++;
     }
-    
-    if (p->pos >= p->length) return NULL;
-    
-    size_t len = p->pos - start;
-    char *value = malloc(len + 1);
-    if (value) {
-        strncpy(value, &p->json[start], len);
-        value[len] = '\0';
+    if (stream->next <= stream->limit) {
+        return flush_json(writer, w) < 0 ? -1 : 1;
     }
-    p->pos++; // Skip closing quote
-    
-    return value;
-}
 
-static int json_parse_int(JSONParser *p) {
-    skip_whitespace(p);
-    
-    int value = 0;
-    int sign = 1;
-    
-    if (p->pos < p->length && p->json[p->pos] == '-') {
-        sign = -1;
-        p->pos++;
-    }
-    
-    while (p->pos < p->length && p->json[p->pos] >= '0' && p->json[p->pos] <= '9') {
-        value = value * 10 + (p->json[p->pos] - '0');
-        p->pos++;
-    }
-    
-    return value * sign;
+    jw_array_end(w);
+    jw_key(w, "count"); jw_int(w, stream->count);
+    jw_object_end(w);
+    return flush_json(writer, w);
 }
 
-static char* json_get_string_value(const char *json, const char *key) {
-    // Find "key":
-    char search[256];
-    snprintf(search, sizeof(search), "\"%s\"", key);
-    
-    const char *key_pos = strstr(json, search);
-    if (!key_pos) return NULL;
-    
-    JSONParser parser = {
-        .json = key_pos + strlen(search),
-        .pos = 0,
-        .length = strlen(key_pos + strlen(search))
-    };
-    
-    // Skip colon
-    skip_whitespace(&parser);
-    if (parser.pos >= parser.length || parser.json[parser.pos] != ':') {
-        return NULL;
-    }
-    parser.pos++;
-    
-    return json_parse_string(&parser);
-}
+// "name=<digits>" in the query: its value, fallback if the parameter is
+// absent, or -1 if it is not a whole number of at most 9 digits
+static long long query_int(const HttpRequest *request, const char *name, long long fallback) {
+    size_t name_length = strlen(name);
+    const char *p = request->query.ptr;
+    const char *end = p + request->query.len;
+    while (p < end) {
+        const char *amp = memchr(p, '&', (size_t)(end - p));
+        const char *param_end = amp ? amp : end;
 
-static int json_get_int_value(const char *json, const char *key) {
-    char search[256];
-    snprintf(search, sizeof(search), "\"%s\"", key);
-    
-    const char *key_pos = strstr(json, search);
-    if (!key_pos) return 0;
-    
-    JSONParser parser = {
-        .json = key_pos + strlen(search),
-        .pos = 0,
-        .length = strlen(key_pos + strlen(search))
-    };
-    
-    // Skip colon
-    skip_whitespace(&parser);
-    if (parser.pos >= parser.length || parser.json[parser.pos] != ':') {
-        return 0;
+        if ((size_t)(param_end - p) > name_length && memcmp(p, name, name_length) == 0 &&
+            p[name_length] == '=') {
+            const char *digits = p + name_length + 1;
+            if (digits == param_end || param_end - digits > 9) return -1;
+            long long value = 0;
+            for (const char *d = digits; d < param_end; d++) {
+                if (*d < '0' || *d > '9') return -1;
+                value = value * 10 + (*d - '0');
+            }
+            return value;
+        }
+        p = param_end + 1;
     }
-    parser.pos++;
-    
-    return json_parse_int(&parser);
+    return fallback;
 }
 
-// ========================================
-// API Endpoints - Production Ready
-// ========================================
+void handle_api_primes(const HttpRequest *request, HttpResponse *response) {
+    long long limit = query_int(request, "limit", PRIMES_DEFAULT_LIMIT);
+    if (limit < 0 || limit > PRIMES_MAX_LIMIT) {
+        send_error(request, response, 400, "limit must be a number from 0 to 1000000");
+        return;
+    }
 
-void handle_api_health(const HttpRequest *request, HttpResponse *response) {
-    (void)request;
-    
-    time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
-    char timestamp[64];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", tm_info);
-    
-    JSONBuilder *jb = json_builder_create();
-    json_builder_append(jb, "{\n");
-    json_builder_append(jb, "  \"status\": \"healthy\",\n");
-    json_builder_append(jb, "  \"service\": \"http-server\",\n");
-    json_builder_append(jb, "  \"version\": \"1.0.0\",\n");
-    
-    char temp[128];
-    snprintf(temp, sizeof(temp), "  \"timestamp\": \"%s\",\n", timestamp);
-    json_builder_append(jb, temp);
-    
-    snprintf(temp, sizeof(temp), "  \"uptime_seconds\": %ld\n", now);
-    json_builder_append(jb, temp);
-    
-    json_builder_append(jb, "}");
-    
-    response->status_code = 200;
-    strcpy(response->content_type, "application/json");
-    response->body = json_builder_finalize(jb);
-    response->body_length = strlen(response->body);
-}
+    PrimeStream *stream = arena_alloc(request->arena, sizeof(PrimeStream));
+    if (!stream) {
+        response->status_code = 500;
+        strcpy(response->content_type, "text/plain");
+        static const char message[] = "Out of memory";
+        http_response_set_static(response, message, sizeof(message) - 1);
+        return;
+    }
 
-void handle_api_users_get(const HttpRequest *request, HttpResponse *response) {
-    (void)request;
-    
-    JSONBuilder *jb = json_builder_create();
-    json_builder_append(jb, "{\n");
-    json_builder_append(jb, "  \"success\": true,\n");
-    json_builder_append(jb, "  \"data\": [\n");
-    
-    json_builder_append(jb, "    {\n");
-    json_builder_append(jb, "      \"id\": 1,\n");
-    json_builder_append(jb, "      \"name\": \"Alice Johnson\",\n");
-    json_builder_append(jb, "      \"email\": \"alice@example.com\",\n");
-    json_builder_append(jb, "      \"role\": \"admin\"\n");
-    json_builder_append(jb, "    },\n");
-    
-    json_builder_append(jb, "    {\n");
-    json_builder_append(jb, "      \"id\": 2,\n");
-    json_builder_append(jb, "      \"name\": \"Bob Smith\",\n");
-    json_builder_append(jb, "      \"email\": \"bob@example.com\",\n");
-    json_builder_append(jb, "      \"role\": \"user\"\n");
-    json_builder_append(jb, "    },\n");
-    
-    json_builder_append(jb, "    {\n");
-    json_builder_append(jb, "      \"id\": 3,\n");
-    json_builder_append(jb, "      \"name\": \"Carol White\",\n");
-    json_builder_append(jb, "      \"email\": \"carol@example.com\",\n");
-    json_builder_append(jb, "      \"role\": \"user\"\n");
-    json_builder_append(jb, "    }\n");
-    
-    json_builder_append(jb, "  ],\n");
-    json_builder_append(jb, "  \"count\": 3\n");
-    json_builder_append(jb, "}");
-    
+    stream->next = 0;
+    stream->limit = limit;
+    stream->count = 0;
+    jw_init(&stream->json, request->arena, json_wants_pretty(request));
     response->status_code = 200;
     strcpy(response->content_type, "application/json");
-    response->body = json_builder_finalize(jb);
-    response->body_length = strlen(response->body);
+    http_response_stream(response, write_primes, stream);
 }
 
 void handle_api_users_post(const HttpRequest *request, HttpResponse *response) {
-    // Parse JSON safely
-    char *name = json_get_string_value(request->body, "name");
-    char *email = json_get_string_value(request->body, "email");
-    char *role = json_get_string_value(request->body, "role");
+    // One pass over the body fills in all of them
+    User user;
+    if (json_decode(request->arena, request->body, &User_schema, &user) < 0) {
+        send_error(request, response, 400, "Request body is not a valid JSON object");
+        return;
+    }
     
-    if (!name || !email) {
-        JSONBuilder *jb = json_builder_create();
-        json_builder_append(jb, "{\n");
-        json_builder_append(jb, "  \"success\": false,\n");
-        json_builder_append(jb, "  \"error\": \"Missing required fields: name and email\"\n");
-        json_builder_append(jb, "}");
-        
-        response->status_code = 400;
-        strcpy(response->content_type, "application/json");
-        response->body = json_builder_finalize(jb);
-        response->body_length = strlen(response->body);
-        
-        free(name);
-        free(email);
-        free(role);
+    if (!user.name || !user.email) {
+        send_error(request, response, 400, "Missing required fields: name and email");
         return;
     }
     
     // Create user
-    int new_id = rand() % 1000 + 100;
-    
-    JSONBuilder *jb = json_builder_create();
-    json_builder_append(jb, "{\n");
-    json_builder_append(jb, "  \"success\": true,\n");
-    json_builder_append(jb, "  \"message\": \"User created successfully\",\n");
-    json_builder_append(jb, "  \"data\": {\n");
-    
-    char temp[512];
-    snprintf(temp, sizeof(temp), "    \"id\": %d,\n", new_id);
-    json_builder_append(jb, temp);
-    
-    json_builder_append(jb, "    \"name\": \"");
-    json_builder_append_escaped(jb, name);
-    json_builder_append(jb, "\",\n");
-    
-    json_builder_append(jb, "    \"email\": \"");
-    json_builder_append_escaped(jb, email);
-    json_builder_append(jb, "\",\n");
-    
-    json_builder_append(jb, "    \"role\": \"");
-    json_builder_append_escaped(jb, role ? role : "user");
-    json_builder_append(jb, "\"\n");
-    
-    json_builder_append(jb, "  }\n");
-    json_builder_append(jb, "}");
-    
-    response->status_code = 201;
-    strcpy(response->content_type, "application/json");
-    response->body = json_builder_finalize(jb);
-    response->body_length = strlen(response->body);
-    
-    free(name);
-    free(email);
-    free(role);
+    user.id = rand() % 1000 + 100;
+    if (!user.role) user.role = "user";
+    
+    JsonWriter w;
+    jw_init(&w, request->arena, json_wants_pretty(request));
+    jw_object_begin(&w);
+    jw_key(&w, "success"); jw_bool(&w, 1);
+    jw_key(&w, "message"); jw_string(&w, "User created successfully");
+    jw_key(&w, "data");    jw_struct(&w, &User_schema, &user);
+    jw_object_end(&w);
+    jw_respond(&w, response, 201);
 }
 
 void handle_api_stats(const HttpRequest *request, HttpResponse *response) {
-    (void)request;
-    
-    JSONBuilder *jb = json_builder_create();
-    json_builder_append(jb, "{\n");
-    json_builder_append(jb, "  \"success\": true,\n");
-    json_builder_append(jb, "  \"data\": {\n");
-    json_builder_append(jb, "    \"requests_total\": 1523,\n");
-    json_builder_append(jb, "    \"requests_per_second\": 12.5,\n");
-    json_builder_append(jb, "    \"active_connections\": 3,\n");
-    json_builder_append(jb, "    \"total_bytes_sent\": 15728640,\n");
-    json_builder_append(jb, "    \"total_bytes_received\": 3145728,\n");
-    json_builder_append(jb, "    \"uptime_hours\": 48.5,\n");
-    json_builder_append(jb, "    \"memory_usage_mb\": 23.4\n");
-    json_builder_append(jb, "  }\n");
-    json_builder_append(jb, "}");
-    
-    response->status_code = 200;
-    strcpy(response->content_type, "application/json");
-    response->body = json_builder_finalize(jb);
-    response->body_length = strlen(response->body);
+    JsonWriter w;
+    jw_init(&w, request->arena, json_wants_pretty(request));
+    jw_object_begin(&w);
+    jw_key(&w, "success"); jw_bool(&w, 1);
+    jw_key(&w, "data");
+    jw_object_begin(&w);
+    jw_key(&w, "requests_total");       jw_int(&w, 1523);
+    jw_key(&w, "requests_per_second");  jw_double(&w, 12.5);
+    jw_key(&w, "active_connections");   jw_int(&w, 3);
+    jw_key(&w, "total_bytes_sent");     jw_int(&w, 15728640);
+    jw_key(&w, "total_bytes_received"); jw_int(&w, 3145728);
+    jw_key(&w, "uptime_hours");         jw_double(&w, 48.5);
+    jw_key(&w, "memory_usage_mb");      jw_double(&w, 23.4);
+    jw_object_end(&w);
+    jw_object_end(&w);
+    jw_respond(&w, response, 200);
 }
 
 void handle_api_login(const HttpRequest *request, HttpResponse *response) {
-    char *username = json_get_string_value(request->body, "username");
-    char *password = json_get_string_value(request->body, "password");
+    LoginRequest login;
+    if (json_decode(request->arena, request->body, &LoginRequest_schema, &login) < 0) {
+        send_error(request, response, 400, "Request body is not a valid JSON object");
+        return;
+    }
     
-    if (!username || !password) {
-        JSONBuilder *jb = json_builder_create();
-        json_builder_append(jb, "{\n");
-        json_builder_append(jb, "  \"success\": false,\n");
-        json_builder_append(jb, "  \"error\": \"Missing username or password\"\n");
-        json_builder_append(jb, "}");
-        
-        response->status_code = 400;
-        strcpy(response->content_type, "application/json");
-        response->body = json_builder_finalize(jb);
-        response->body_length = strlen(response->body);
-        
-        free(username);
-        free(password);
+    if (!login.username || !login.password) {
+        send_error(request, response, 400, "Missing username or password");
         return;
     }
     
     // Authenticate
-    if (strcmp(username, "admin") == 0 && strcmp(password, "password") == 0) {
-        JSONBuilder *jb = json_builder_create();
-        json_builder_append(jb, "{\n");
-        json_builder_append(jb, "  \"success\": true,\n");
-        json_builder_append(jb, "  \"message\": \"Login successful\",\n");
-        json_builder_append(jb, "  \"data\": {\n");
-        
-        json_builder_append(jb, "    \"user\": \"");
-        json_builder_append_escaped(jb, username);
-        json_builder_append(jb, "\",\n");
-        
-        json_builder_append(jb, "    \"token\": \"eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9\",\n");
-        json_builder_append(jb, "    \"expires_in\": 3600\n");
-        json_builder_append(jb, "  }\n");
-        json_builder_append(jb, "}");
-        
-        response->status_code = 200;
-        strcpy(response->content_type, "application/json");
-        response->body = json_builder_finalize(jb);
-        response->body_length = strlen(response->body);
+    if (strcmp(login.username, "admin") == 0 && strcmp(login.password, "password") == 0) {
+        LoginResult result = {
+            .user = login.username,
+            .token = "eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9",
+            .expires_in = 3600,
+        };
+        JsonWriter w;
+        jw_init(&w, request->arena, json_wants_pretty(request));
+        jw_object_begin(&w);
+        jw_key(&w, "success"); jw_bool(&w, 1);
+        jw_key(&w, "message"); jw_string(&w, "Login successful");
+        jw_key(&w, "data");    jw_struct(&w, &LoginResult_schema, &result);
+        jw_object_end(&w);
+        jw_respond(&w, response, 200);
     } else {
-        JSONBuilder *jb = json_builder_create();
-        json_builder_append(jb, "{\n");
-        json_builder_append(jb, "  \"success\": false,\n");
-        json_builder_append(jb, "  \"error\": \"Invalid credentials\"\n");
-        json_builder_append(jb, "}");
-        
-        response->status_code = 401;
-        strcpy(response->content_type, "application/json");
-        response->body = json_builder_finalize(jb);
-        response->body_length = strlen(response->body);
+        send_error(request, response, 401, "Invalid credentials");
     }
-    
-    free(username);
-    free(password);
 }
 
 void handle_api_calculate(const HttpRequest *request, HttpResponse *response) {
-    int a = json_get_int_value(request->body, "a");
-    int b = json_get_int_value(request->body, "b");
-    char *operation = json_get_string_value(request->body, "operation");
+    Calculation calc;   // a and b are 0 if missing
+    if (json_decode(request->arena, request->body, &Calculation_schema, &calc) < 0) {
+        send_error(request, response, 400, "Request body is not a valid JSON object");
+        return;
+    }
+    long long a = calc.a;
+    long long b = calc.b;
+    const char *operation = calc.operation;
     
     if (!operation) {
-        JSONBuilder *jb = json_builder_create();
-        json_builder_append(jb, "{\n");
-        json_builder_append(jb, "  \"success\": false,\n");
-        json_builder_append(jb, "  \"error\": \"Missing operation field\"\n");
-        json_builder_append(jb, "}");
-        
-        response->status_code = 400;
-        strcpy(response->content_type, "application/json");
-        response->body = json_builder_finalize(jb);
-        response->body_length = strlen(response->body);
+        send_error(request, response, 400, "Missing operation field");
         return;
     }
     
     double result = 0;
     int valid = 1;
     
+    // In double: the operands can be any 64-bit integer
     if (strcmp(operation, "add") == 0) {
-        result = a + b;
+        result = (double)a + (double)b;
     } else if (strcmp(operation, "subtract") == 0) {
-        result = a - b;
+        result = (double)a - (double)b;
     } else if (strcmp(operation, "multiply") == 0) {
-        result = a * b;
+        result = (double)a * (double)b;
     } else if (strcmp(operation, "divide") == 0) {
         if (b == 0) {
-            JSONBuilder *jb = json_builder_create();
-            json_builder_append(jb, "{\n");
-            json_builder_append(jb, "  \"success\": false,\n");
-            json_builder_append(jb, "  \"error\": \"Division by zero\"\n");
-            json_builder_append(jb, "}");
-            
-            response->status_code = 400;
-            strcpy(response->content_type, "application/json");
-            response->body = json_builder_finalize(jb);
-            response->body_length = strlen(response->body);
-            
-            free(operation);
+            send_error(request, response, 400, "Division by zero");
             return;
         }
-        result = (double)a / b;
+        result = (double)a / (double)b;
     } else {
         valid = 0;
     }
     
     if (valid) {
-        JSONBuilder *jb = json_builder_create();
-        json_builder_append(jb, "{\n");
-        json_builder_append(jb, "  \"success\": true,\n");
-        json_builder_append(jb, "  \"data\": {\n");
-        
-        char temp[256];
-        snprintf(temp, sizeof(temp), "    \"a\": %d,\n", a);
-        json_builder_append(jb, temp);
-        
-        snprintf(temp, sizeof(temp), "    \"b\": %d,\n", b);
-        json_builder_append(jb, temp);
-        
-        json_builder_append(jb, "    \"operation\": \"");
-        json_builder_append_escaped(jb, operation);
-        json_builder_append(jb, "\",\n");
-        
-        snprintf(temp, sizeof(temp), "    \"result\": %.2f\n", result);
-        json_builder_append(jb, temp);
-        
-        json_builder_append(jb, "  }\n");
-        json_builder_append(jb, "}");
-        
-        response->status_code = 200;
-        strcpy(response->content_type, "application/json");
-        response->body = json_builder_finalize(jb);
-        response->body_length = strlen(response->body);
+        calc.result = result;   // Whatever the body said, it is ours
+        JsonWriter w;
+        jw_init(&w, request->arena, json_wants_pretty(request));
+        jw_object_begin(&w);
+        jw_key(&w, "success"); jw_bool(&w, 1);
+        jw_key(&w, "data");    jw_struct(&w, &Calculation_schema, &calc);
+        jw_object_end(&w);
+        jw_respond(&w, response, 200);
     } else {
-        JSONBuilder *jb = json_builder_create();
-        json_builder_append(jb, "{\n");
-        json_builder_append(jb, "  \"success\": false,\n");
-        json_builder_append(jb, "  \"error\": \"Invalid operation. Use: add, subtract, multiply, divide\"\n");
-        json_builder_append(jb, "}");
-        
-        response->status_code = 400;
-        strcpy(response->content_type, "application/json");
-        response->body = json_builder_finalize(jb);
-        response->body_length = strlen(response->body);
+        send_error(request, response, 400,
+                   "Invalid operation. Use: add, subtract, multiply, divide");
     }
-    
-    free(operation);
 }
 
 void handle_api_time(const HttpRequest *request, HttpResponse *response) {
-    (void)request;
-    
     time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
+    struct tm tm_buf;
+    struct tm *tm_info = localtime_r(&now, &tm_buf);
     
     char date[32], time_str[32], iso[64];
     strftime(date, sizeof(date), "%Y-%m-%d", tm_info);
     strftime(time_str, sizeof(time_str), "%H:%M:%S", tm_info);
     strftime(iso, sizeof(iso), "%Y-%m-%dT%H:%M:%S", tm_info);
     
-    JSONBuilder *jb = json_builder_create();
-    json_builder_append(jb, "{\n");
-    json_builder_append(jb, "  \"success\": true,\n");
-    json_builder_append(jb, "  \"data\": {\n");
-    
-    char temp[256];
-    snprintf(temp, sizeof(temp), "    \"timestamp\": %ld,\n", now);
-    json_builder_append(jb, temp);
-    
-    snprintf(temp, sizeof(temp), "    \"iso\": \"%s\",\n", iso);
-    json_builder_append(jb, temp);
-    
-    snprintf(temp, sizeof(temp), "    \"date\": \"%s\",\n", date);
-    json_builder_append(jb, temp);
-    
-    snprintf(temp, sizeof(temp), "    \"time\": \"%s\",\n", time_str);
-    json_builder_append(jb, temp);
-    
-    json_builder_append(jb, "    \"timezone\": \"UTC\"\n");
-    json_builder_append(jb, "  }\n");
-    json_builder_append(jb, "}");
-    
-    response->status_code = 200;
-    strcpy(response->content_type, "application/json");
-    response->body = json_builder_finalize(jb);
-    response->body_length = strlen(response->body);
-}
\ No newline at end of file
+    JsonWriter w;
+    jw_init(&w, request->arena, json_wants_pretty(request));
+    jw_object_begin(&w);
+    jw_key(&w, "success");   jw_bool(&w, 1);
+    jw_key(&w, "data");
+    jw_object_begin(&w);
+    jw_key(&w, "timestamp"); jw_int(&w, (long long)now);
+    jw_key(&w, "iso");       jw_string(&w, iso);
+    jw_key(&w, "date");      jw_string(&w, date);
+    jw_key(&w, "time");      jw_string(&w, time_str);
+    jw_key(&w, "timezone");  jw_string(&w, "UTC");
+    jw_object_end(&w);
+    jw_object_end(&w);
+    jw_respond(&w, response, 200);
+}
@@ -167,80 +167,56 @@ static HTTPResponse http_get(const char *host, const char *path, int port) {
 // JSON Parser (for external API responses)
 // ========================================
 
-// Extract string value from JSON (handles nested paths like "main.temp")
-static char* json_extract_string(const char *json, const char *path) {
-    char *current_json = (char*)json;
+// The node at a path like "main.temp" or "data.1.id" (numbers index
+// arrays); NULL if there is nothing there
+static const JsonNode *json_lookup(const JsonDocument *doc, const char *path) {
+    const JsonNode *node = doc->nodes;
     char path_copy[256];
-    strncpy(path_copy, path, sizeof(path_copy) - 1);
-    
-    char *token = strtok(path_copy, ".");
-    
-    while (token) {
-        // Find "token":
-        char search[128];
-        snprintf(search, sizeof(search), "\"%s\"", token);
-        
-        char *key_pos = strstr(current_json, search);
-        if (!key_pos) return NULL;
-        
-        // Find the value after the colon
-        char *colon = strchr(key_pos, ':');
-        if (!colon) return NULL;
-        
-        colon++; // Skip colon
-        
-        // Skip whitespace
-        while (*colon == ' ' || *colon == '\t' || *colon == '\n' || *colon == '\r') {
-            colon++;
-        }
-        
-        // Check if next token exists (nested object)
-        token = strtok(NULL, ".");
-        
-        if (!token) {
-            // This is the final value
-            if (*colon == '"') {
-                // String value
-                char *start = colon + 1;
-                char *end = strchr(start, '"');
-                if (!end) return NULL;
-                
-                size_t len = end - start;
-                char *result = malloc(len + 1);
-                if (result) {
-                    strncpy(result, start, len);
-                    result[len] = '\0';
-                }
-                return result;
-            } else {
-                // Number or other value as string
-                char *start = colon;
-                char *end = start;
-                while (*end && *end != ',' && *end != '}' && *end != ']' && 
-                       *end != '\n' && *end != '\r') {
-                    end++;
-                }
-                
-                // Trim trailing whitespace
-                while (end > start && (*(end-1) == ' ' || *(end-1) == '\t')) {
-                    end--;
-                }
-                
-                size_t len = end - start;
-                char *result = malloc(len + 1);
-                if (result) {
-                    strncpy(result, start, len);
-                    result[len] = '\0';
-                }
-                return result;
-            }
+    snprintf(path_copy, sizeof(path_copy), "%s", path);
+    
+    char *saveptr = NULL;  // strtok_r keeps its position here, not in a shared static
+    for (char *token = strtok_r(path_copy, ".", &saveptr); token && node;
+         token = strtok_r(NULL, ".", &saveptr)) {
+        if (node->type == JSON_NODE_OBJECT) {
+            node = json_object_get(node, token);
+        } else if (node->type == JSON_NODE_ARRAY) {
+            char *end;
+            unsigned long index = strtoul(token, &end, 10);
+            if (*end || index >= node->count) return NULL;
+            node++;
+            while (index--) node = json_node_next(node);
         } else {
-            // Move to nested object
-            current_json = colon;
+            return NULL;
+        }
+    }
+    return node;
+}
+
+// Extract a value from JSON as a malloc'd string (handles nested paths
+// like "main.temp"). The whole body is parsed into a tape first, so a
+// key-like string inside some other value can never match.
+static char* json_extract_string(const char *json, const char *path) {
+    Arena arena = {0};
+    JsonDocument doc;
+    char *result = NULL;
+    
+    if (json_parse(&arena, (HttpStr){json, strlen(json)}, &doc) == 0) {
+        const JsonNode *node = json_lookup(&doc, path);
+        if (node && node->type == JSON_NODE_STRING) {
+            size_t len;
+            char *value = json_node_string(&arena, node, &len);
+            if (value) result = strndup(value, len);
+        } else if (node && node->type == JSON_NODE_NUMBER) {
+            // Number as it was written
+            result = strndup(node->text, node->length);
+        } else if (node && node->type >= JSON_NODE_TRUE) {
+            result = strdup(node->type == JSON_NODE_TRUE ? "true" :
+                            node->type == JSON_NODE_FALSE ? "false" : "null");
         }
     }
     
-    return NULL;
+    arena_reset(&arena);
+    return result;
 }
 
 static double json_extract_number(const char *json, const char *path) __attribute__((unused));
@@ -259,8 +235,6 @@ static double json_extract_number(const char *json, const char *path) {
 // ========================================
 
 void handle_api_weather(const HttpRequest *request, HttpResponse *response) {
-    (void)request;
-    
     // Use a simpler weather API that works with HTTP
     // wttr.in supports both HTTP and returns plain text formats
     printf("[API] Calling weather API (HTTP)...\n");
@@ -268,26 +242,18 @@ void handle_api_weather(const HttpRequest *request, HttpResponse *response) {
     // Use simple text format instead of JSON for HTTP
     HTTPResponse api_response = http_get("wttr.in", "/London?format=3", 80);
     
+    JsonWriter w;
+    jw_init(&w, request->arena, json_wants_pretty(request));
+    jw_object_begin(&w);
+    
     if (api_response.error) {
         printf("[API] Error: %s\n", api_response.error);
         
-        JSONBuilder *jb = json_builder_create();
-        json_builder_append(jb, "{\n");
-        json_builder_append(jb, "  \"success\": false,\n");
-        json_builder_append(jb, "  \"error\": \"Failed to fetch weather data\",\n");
-        
-        char temp[256];
-        snprintf(temp, sizeof(temp), "  \"details\": \"");
-        json_builder_append(jb, temp);
-        json_builder_append_escaped(jb, api_response.error);
-        json_builder_append(jb, "\"\n");
-        
-        json_builder_append(jb, "}");
-        
-        response->status_code = 502;
-        strcpy(response->content_type, "application/json");
-        response->body = json_builder_finalize(jb);
-        response->body_length = strlen(response->body);
+        jw_key(&w, "success"); jw_bool(&w, 0);
+        jw_key(&w, "error");   jw_string(&w, "Failed to fetch weather data");
+        jw_key(&w, "details"); jw_string(&w, api_response.error);
+        jw_object_end(&w);
+        jw_respond(&w, response, 502);
         
         http_response_free(&api_response);
         return;
@@ -298,68 +264,48 @@ void handle_api_weather(const HttpRequest *request, HttpResponse *response) {
     
     // Check for redirects or errors
     if (api_response.status_code != 200) {
-        JSONBuilder *jb = json_builder_create();
-        json_builder_append(jb, "{\n");
-        json_builder_append(jb, "  \"success\": false,\n");
-        
-        char temp[256];
+        jw_key(&w, "success"); jw_bool(&w, 0);
+        jw_key(&w, "error");
         if (api_response.status_code == 301 || api_response.status_code == 302) {
-            snprintf(temp, sizeof(temp), 
-                "  \"error\": \"Weather API redirected (try HTTPS)\",\n");
+            jw_string(&w, "Weather API redirected (try HTTPS)");
         } else {
-            snprintf(temp, sizeof(temp), 
-                "  \"error\": \"Weather API returned status %d\",\n",
-                api_response.status_code);
+            char message[64];
+            snprintf(message, sizeof(message), "Weather API returned status %d",
+                     api_response.status_code);
+            jw_string(&w, message);
         }
-        json_builder_append(jb, temp);
-        
-        snprintf(temp, sizeof(temp), "  \"status_code\": %d\n", 
-                api_response.status_code);
-        json_builder_append(jb, temp);
-        json_builder_append(jb, "}");
-        
-        response->status_code = 502;
-        strcpy(response->content_type, "application/json");
-        response->body = json_builder_finalize(jb);
-        response->body_length = strlen(response->body);
+        jw_key(&w, "status_code"); jw_int(&w, api_response.status_code);
+        jw_object_end(&w);
+        jw_respond(&w, response, 502);
         
         http_response_free(&api_response);
         return;
     }
     
     // Parse simple format: "London: ☀️ +15°C"
-    JSONBuilder *jb = json_builder_create();
-    json_builder_append(jb, "{\n");
-    json_builder_append(jb, "  \"success\": true,\n");
-    json_builder_append(jb, "  \"location\": \"London\",\n");
-    json_builder_append(jb, "  \"data\": {\n");
-    json_builder_append(jb, "    \"weather\": \"");
-    
-    // Clean and escape the response
+    jw_key(&w, "success");  jw_bool(&w, 1);
+    jw_key(&w, "location"); jw_string(&w, "London");
+    jw_key(&w, "data");
+    jw_object_begin(&w);
+    jw_key(&w, "weather");
+    
     if (api_response.body && api_response.body_length > 0) {
-        // Remove newlines
-        char *cleaned = strdup(api_response.body);
-        for (size_t i = 0; cleaned[i]; i++) {
-            if (cleaned[i] == '\n' || cleaned[i] == '\r') {
-                cleaned[i] = ' ';
-            }
+        // Without the trailing newline; anything else is escaped
+        size_t length = api_response.body_length;
+        while (length > 0 && (api_response.body[length - 1] == '\n' ||
+                              api_response.body[length - 1] == '\r')) {
+            length--;
         }
-        json_builder_append_escaped(jb, cleaned);
-        free(cleaned);
+        jw_string_n(&w, api_response.body, length);
     } else {
-        json_builder_append(jb, "Unknown");
+        jw_string(&w, "Unknown");
     }
     
-    json_builder_append(jb, "\"\n");
-    json_builder_append(jb, "  },\n");
-    json_builder_append(jb, "  \"source\": \"wttr.in\",\n");
-    json_builder_append(jb, "  \"note\": \"Using HTTP endpoint (limited data)\"\n");
-    json_builder_append(jb, "}");
-    
-    response->status_code = 200;
-    strcpy(response->content_type, "application/json");
-    response->body = json_builder_finalize(jb);
-    response->body_length = strlen(response->body);
+    jw_object_end(&w);
+    jw_key(&w, "source"); jw_string(&w, "wttr.in");
+    jw_key(&w, "note");   jw_string(&w, "Using HTTP endpoint (limited data)");
+    jw_object_end(&w);
+    jw_respond(&w, response, 200);
     
     http_response_free(&api_response);
 }
@@ -369,34 +315,31 @@ void handle_api_weather(const HttpRequest *request, HttpResponse *response) {
 // ========================================
 
 void handle_api_exchange_rates(const HttpRequest *request, HttpResponse *response) {
-    (void)request;
-    
     printf("[API] Exchange rates endpoint called\n");
     
     // Most currency APIs require HTTPS (port 443) which we don't support
     // Provide helpful error message
-    JSONBuilder *jb = json_builder_create();
-    json_builder_append(jb, "{\n");
-    json_builder_append(jb, "  \"success\": false,\n");
-    json_builder_append(jb, "  \"error\": \"Exchange rate APIs require HTTPS\",\n");
-    json_builder_append(jb, "  \"info\": \"This server doesn't support SSL/TLS connections\",\n");
-    json_builder_append(jb, "  \"suggestion\": \"To enable this, add OpenSSL library support\",\n");
-    json_builder_append(jb, "  \"sample_data\": {\n");
-    json_builder_append(jb, "    \"base\": \"USD\",\n");
-    json_builder_append(jb, "    \"rates\": {\n");
-    json_builder_append(jb, "      \"EUR\": 0.85,\n");
-    json_builder_append(jb, "      \"GBP\": 0.73,\n");
-    json_builder_append(jb, "      \"JPY\": 110.25,\n");
-    json_builder_append(jb, "      \"CAD\": 1.25\n");
-    json_builder_append(jb, "    },\n");
-    json_builder_append(jb, "    \"note\": \"This is sample data, not live rates\"\n");
-    json_builder_append(jb, "  }\n");
-    json_builder_append(jb, "}");
-    
-    response->status_code = 501; // Not Implemented
-    strcpy(response->content_type, "application/json");
-    response->body = json_builder_finalize(jb);
-    response->body_length = strlen(response->body);
+    JsonWriter w;
+    jw_init(&w, request->arena, json_wants_pretty(request));
+    jw_object_begin(&w);
+    jw_key(&w, "success");    jw_bool(&w, 0);
+    jw_key(&w, "error");      jw_string(&w, "Exchange rate APIs require HTTPS");
+    jw_key(&w, "info");       jw_string(&w, "This server doesn't support SSL/TLS connections");
+    jw_key(&w, "suggestion"); jw_string(&w, "To enable this, add OpenSSL library support");
+    jw_key(&w, "sample_data");
+    jw_object_begin(&w);
+    jw_key(&w, "base");       jw_string(&w, "USD");
+    jw_key(&w, "rates");
+    jw_object_begin(&w);
+    jw_key(&w, "EUR");        jw_double(&w, 0.85);
+    jw_key(&w, "GBP");        jw_double(&w, 0.73);
+    jw_key(&w, "JPY");        jw_double(&w, 110.25);
+    jw_key(&w, "CAD");        jw_double(&w, 1.25);
+    jw_object_end(&w);
+    jw_key(&w, "note");       jw_string(&w, "This is sample data, not live rates");
+    jw_object_end(&w);
+    jw_object_end(&w);
+    jw_respond(&w, response, 501);  // Not Implemented
 }
 
 // ========================================
@@ -404,28 +347,24 @@ void handle_api_exchange_rates(const HttpRequest *request, HttpResponse *respons
 // ========================================
 
 void handle_api_quote(const HttpRequest *request, HttpResponse *response) {
-    (void)request;
-    
     printf("[API] Quote endpoint called\n");
     
     // Most quote APIs require HTTPS
-    JSONBuilder *jb = json_builder_create();
-    json_builder_append(jb, "{\n");
-    json_builder_append(jb, "  \"success\": false,\n");
-    json_builder_append(jb, "  \"error\": \"Quote APIs require HTTPS\",\n");
-    json_builder_append(jb, "  \"info\": \"This server uses plain HTTP (no SSL/TLS)\",\n");
-    json_builder_append(jb, "  \"sample_quote\": {\n");
-    json_builder_append(jb, "    \"quote\": \"The only way to do great work is to love what you do.\",\n");
-    json_builder_append(jb, "    \"author\": \"Steve Jobs\",\n");
-    json_builder_append(jb, "    \"note\": \"This is a sample quote, not from API\"\n");
-    json_builder_append(jb, "  },\n");
-    json_builder_append(jb, "  \"how_to_fix\": \"Add OpenSSL library for HTTPS support\"\n");
-    json_builder_append(jb, "}");
-    
-    response->status_code = 501; // Not Implemented
-    strcpy(response->content_type, "application/json");
-    response->body = json_builder_finalize(jb);
-    response->body_length = strlen(response->body);
+    JsonWriter w;
+    jw_init(&w, request->arena, json_wants_pretty(request));
+    jw_object_begin(&w);
+    jw_key(&w, "success"); jw_bool(&w, 0);
+    jw_key(&w, "error");   jw_string(&w, "Quote APIs require HTTPS");
+    jw_key(&w, "info");    jw_string(&w, "This server uses plain HTTP (no SSL/TLS)");
+    jw_key(&w, "sample_quote");
+    jw_object_begin(&w);
+    jw_key(&w, "quote");   jw_string(&w, "The only way to do great work is to love what you do.");
+    jw_key(&w, "author");  jw_string(&w, "Steve Jobs");
+    jw_key(&w, "note");    jw_string(&w, "This is a sample quote, not from API");
+    jw_object_end(&w);
+    jw_key(&w, "how_to_fix"); jw_string(&w, "Add OpenSSL library for HTTPS support");
+    jw_object_end(&w);
+    jw_respond(&w, response, 501);  // Not Implemented
 }
 
 // ========================================
@@ -433,28 +372,24 @@ void handle_api_quote(const HttpRequest *request, HttpResponse *response) {
 // ========================================
 
 void handle_api_proxy(const HttpRequest *request, HttpResponse *response) {
-    (void)request;
-    
     printf("[API] Proxy endpoint called\n");
     
     // GitHub API requires HTTPS
-    JSONBuilder *jb = json_builder_create();
-    json_builder_append(jb, "{\n");
-    json_builder_append(jb, "  \"success\": false,\n");
-    json_builder_append(jb, "  \"error\": \"Proxy target requires HTTPS\",\n");
-    json_builder_append(jb, "  \"info\": \"Most modern APIs use HTTPS (SSL/TLS)\",\n");
-    json_builder_append(jb, "  \"limitation\": \"This server only supports plain HTTP\",\n");
-    json_builder_append(jb, "  \"how_it_would_work\": {\n");
-    json_builder_append(jb, "    \"step1\": \"Your server receives request\",\n");
-    json_builder_append(jb, "    \"step2\": \"Your server calls external API\",\n");
-    json_builder_append(jb, "    \"step3\": \"External API returns data\",\n");
-    json_builder_append(jb, "    \"step4\": \"Your server forwards response to client\"\n");
-    json_builder_append(jb, "  },\n");
-    json_builder_append(jb, "  \"note\": \"This is how API proxies/gateways work!\"\n");
-    json_builder_append(jb, "}");
-    
-    response->status_code = 501; // Not Implemented  
-    strcpy(response->content_type, "application/json");
-    response->body = json_builder_finalize(jb);
-    response->body_length = strlen(response->body);
-}
\ No newline at end of file
+    JsonWriter w;
+    jw_init(&w, request->arena, json_wants_pretty(request));
+    jw_object_begin(&w);
+    jw_key(&w, "success");    jw_bool(&w, 0);
+    jw_key(&w, "error");      jw_string(&w, "Proxy target requires HTTPS");
+    jw_key(&w, "info");       jw_string(&w, "Most modern APIs use HTTPS (SSL/TLS)");
+    jw_key(&w, "limitation"); jw_string(&w, "This server only supports plain HTTP");
+    jw_key(&w, "how_it_would_work");
+    jw_object_begin(&w);
+    jw_key(&w, "step1");      jw_string(&w, "Your server receives request");
+    jw_key(&w, "step2");      jw_string(&w, "Your server calls external API");
+    jw_key(&w, "step3");      jw_string(&w, "External API returns data");
+    jw_key(&w, "step4");      jw_string(&w, "Your server forwards response to client");
+    jw_object_end(&w);
+    jw_key(&w, "note");       jw_string(&w, "This is how API proxies/gateways work!");
+    jw_object_end(&w);
+    jw_respond(&w, response, 501);  // Not Implemented
+}
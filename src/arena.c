@@ -0,0 +1,150 @@
+#include "http_server.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/* ============================================
+   REQUEST ARENA
+   ============================================
+   Answering one request used to take a handful of separate
+   malloc()/free() pairs: the JSON builder and its buffer, each string
+   pulled out of the request body, the response headers, the body.
+   Every one of them lives exactly as long as the request does.
+
+   An arena exploits that. Memory comes from one block, handed out by
+   bumping a pointer:
+
+       block: [ builder | "alice" | headers | body ....... | free ]
+                                                          ^ used
+
+   Nothing is freed on its own. When the response has been sent, the
+   whole arena is reset in one step and the next request starts again
+   at the beginning.
+
+   Blocks come from the worker's buffer pool, and a reset gives them
+   back to it, so a steady stream of requests reuses the same few
+   blocks without calling malloc() at all - and an idle connection
+   holds none. A request that needs more than the first block simply
+   gets a second, bigger one.
+   ============================================ */
+
+#define ARENA_FIRST_BLOCK 4096
+#define ARENA_ALIGN 16
+
+// Block header; the allocations follow it
+struct ArenaBlock {
+    struct ArenaBlock *next;    // The block filled before this one
+    size_t capacity;            // Size of the whole block, header included
+    size_t used;                // Bytes handed out, header included
+};
+
+#define ARENA_HEADER ((sizeof(ArenaBlock) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+static size_t align_up(size_t size) {
+    return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+// Room left in the current block
+static size_t arena_space(const Arena *arena) {
+    const ArenaBlock *block = arena->blocks;
+    return block ? block->capacity - block->used : 0;
+}
+
+static int add_block(Arena *arena, size_t size) {
+    // At least double the last block, so a big request needs few of them
+    size_t wanted = ARENA_FIRST_BLOCK;
+    if (arena->blocks) wanted = arena->blocks->capacity * 2;
+    if (wanted < ARENA_HEADER + size) wanted = ARENA_HEADER + size;
+
+    size_t capacity;
+    ArenaBlock *block = (ArenaBlock *)buffer_pool_acquire(wanted, &capacity);
+    if (!block) return -1;
+
+    block->next = arena->blocks;
+    block->capacity = capacity;
+    block->used = ARENA_HEADER;
+    arena->blocks = block;
+    return 0;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    size = align_up(size ? size : 1);
+    if (arena_space(arena) < size && add_block(arena, size) < 0) return NULL;
+
+    ArenaBlock *block = arena->blocks;
+    void *ptr = (char *)block + block->used;
+    block->used += size;
+    arena->last = ptr;
+    return ptr;
+}
+
+void *arena_grow(Arena *arena, void *ptr, size_t old_size, size_t new_size) {
+    if (!ptr) return arena_alloc(arena, new_size);
+    if (new_size <= old_size) return ptr;
+
+    // The most recent allocation can usually just extend into the free
+    // space after it
+    if (ptr == arena->last) {
+        ArenaBlock *block = arena->blocks;
+        size_t start = (size_t)((char *)ptr - (char *)block);
+        if (start + align_up(new_size) <= block->capacity) {
+            block->used = start + align_up(new_size);
+            return ptr;
+        }
+    }
+
+    void *bigger = arena_alloc(arena, new_size);
+    if (bigger) memcpy(bigger, ptr, old_size);
+    return bigger;
+}
+
+char *arena_strndup(Arena *arena, const char *str, size_t length) {
+    char *copy = arena_alloc(arena, length + 1);
+    if (!copy) return NULL;
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+char *arena_printf(Arena *arena, size_t *length, const char *format, ...) {
+    // Format straight into the free space; only if it does not fit,
+    // measure, get a big enough block and format again
+    ArenaBlock *block = arena->blocks;
+    char *out = block ? (char *)block + block->used : NULL;
+    size_t space = arena_space(arena);
+
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(out, space, format, args);
+    va_end(args);
+    if (n < 0) {
+        *length = 0;
+        return NULL;
+    }
+
+    if ((size_t)n >= space) {
+        out = arena_alloc(arena, (size_t)n + 1);
+        if (!out) {
+            *length = 0;
+            return NULL;
+        }
+        va_start(args, format);
+        vsnprintf(out, (size_t)n + 1, format, args);
+        va_end(args);
+    } else {
+        block->used += align_up((size_t)n + 1);
+        arena->last = out;
+    }
+
+    *length = (size_t)n;
+    return out;
+}
+
+void arena_reset(Arena *arena) {
+    while (arena->blocks) {
+        ArenaBlock *next = arena->blocks->next;
+        buffer_pool_release((char *)arena->blocks, arena->blocks->capacity);
+        arena->blocks = next;
+    }
+    arena->last = NULL;
+}
@@ -0,0 +1,128 @@
+#include "http_server.h"
+#include <stdlib.h>
+
+/* ============================================
+   BUFFER POOL
+   ============================================
+   Every connection needs somewhere to put the bytes it receives.
+   Giving each one a fixed 64KB buffer is simple, but 10,000 idle
+   keep-alive clients would then pin 640MB doing nothing.
+
+   Instead buffers come in a few size classes (4KB, 16KB, 64KB,
+   256KB, 1MB). A connection starts with the smallest, trades it for
+   a bigger class only when a request does not fit, and gives it
+   back as soon as everything received has been answered. Idle
+   connections hold no buffer at all.
+
+   Returned buffers go onto a free list per size class, so the next
+   connection reuses them without calling malloc(). The lists are
+   per thread (_Thread_local): a connection is only ever touched by
+   the worker that owns it, so no locking is needed. Each list keeps
+   at most POOL_CACHE_BYTES; anything beyond that goes back to the
+   system.
+
+   Requests bigger than the largest class (large uploads) get a
+   plain malloc() that is freed on release.
+   ============================================ */
+
+#define POOL_CLASSES 5
+#define POOL_CACHE_BYTES (2 * 1024 * 1024)   // Per class, per thread
+
+static const size_t class_sizes[POOL_CLASSES] = {
+    4 * 1024, 16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024
+};
+
+// A free buffer stores the link to the next one in its own first bytes
+typedef struct FreeBuffer {
+    struct FreeBuffer *next;
+} FreeBuffer;
+
+typedef struct {
+    FreeBuffer *head;
+    size_t count;
+} FreeList;
+
+static _Thread_local FreeList free_lists[POOL_CLASSES];
+
+// Smallest class that holds `size` bytes, or -1 if none does
+static int size_class(size_t size) {
+    for (int i = 0; i < POOL_CLASSES; i++) {
+        if (size <= class_sizes[i]) return i;
+    }
+    return -1;
+}
+
+char *buffer_pool_acquire(size_t size, size_t *capacity) {
+    int cls = size_class(size);
+    if (cls < 0) {
+        char *buffer = malloc(size);
+        if (buffer) *capacity = size;
+        return buffer;
+    }
+
+    FreeList *list = &free_lists[cls];
+    if (list->head) {
+        FreeBuffer *buffer = list->head;
+        list->head = buffer->next;
+        list->count--;
+        *capacity = class_sizes[cls];
+        return (char *)buffer;
+    }
+
+    char *buffer = malloc(class_sizes[cls]);
+    if (buffer) *capacity = class_sizes[cls];
+    return buffer;
+}
+
+void buffer_pool_release(char *buffer, size_t capacity) {
+    if (!buffer) return;
+
+    int cls = size_class(capacity);
+    if (cls < 0 || class_sizes[cls] != capacity ||
+        (free_lists[cls].count + 1) * capacity > POOL_CACHE_BYTES) {
+        free(buffer);
+        return;
+    }
+
+    FreeBuffer *node = (FreeBuffer *)buffer;
+    node->next = free_lists[cls].head;
+    free_lists[cls].head = node;
+    free_lists[cls].count++;
+}
+
+void buffer_pool_trim(void) {
+    for (int i = 0; i < POOL_CLASSES; i++) {
+        while (free_lists[i].head) {
+            FreeBuffer *next = free_lists[i].head->next;
+            free(free_lists[i].head);
+            free_lists[i].head = next;
+        }
+        free_lists[i].count = 0;
+    }
+}
+
+/* ============================================
+   SHARED BUFFERS
+   ============================================
+   Some bodies are sent to many clients unchanged - a compressed page
+   kept in a cache, say. Copying it into a fresh buffer for every
+   response only so that the response can free() it afterwards costs
+   a malloc, a memcpy and a free each time.
+
+   A shared buffer counts its users instead: the cache holds one
+   reference, every response still sending it holds another, and
+   whoever drops the last one frees it. Evicting it from the cache
+   while a slow client is still downloading it is then harmless.
+   ============================================ */
+
+SharedBuffer *shared_buffer_create(size_t length) {
+    SharedBuffer *buffer = malloc(sizeof(SharedBuffer) + length);
+    if (!buffer) return NULL;
+    buffer->refs = 1;
+    buffer->length = length;
+    return buffer;
+}
+
+void shared_buffer_release(SharedBuffer *buffer) {
+    if (buffer && --buffer->refs == 0) free(buffer);
+}
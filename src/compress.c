@@ -0,0 +1,235 @@
+#include "http_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <zlib.h>
+
+/* ============================================
+   RESPONSE COMPRESSION
+   ============================================
+   HTML and JSON are text, and text compresses well: a 20KB page is
+   often 5KB gzipped. A client lists the codings it can undo:
+
+       Accept-Encoding: gzip, deflate, br
+
+   and we may then send the body compressed, saying which coding we
+   used so it can be decoded:
+
+       Content-Encoding: gzip
+       Content-Length: 5231        <- the compressed size
+       Vary: Accept-Encoding       <- caches: the answer depends on it
+
+   Not everything is worth it:
+   - tiny bodies (below COMPRESS_MIN_BYTES) barely shrink, and the
+     gzip header and trailer alone are 18 bytes
+   - images, video and archives are already compressed; only types
+     on a short text allowlist are compressed
+   - file bodies are sent with sendfile() and never pass through our
+     memory, so they go out as they are
+
+   Compressing costs CPU on every response, so the result of a body
+   that is the same for everyone (static text, or one its handler
+   marked with body_cacheable) is kept in a small per-thread cache: the
+   same page answered a thousand times is compressed once. A cached
+   result is a shared buffer, sent to every client from the cache
+   itself. The entry also keeps a copy of the uncompressed body, and a
+   hit must match it byte for byte: a hash alone could collide and
+   hand one client another client's data. Per-request bodies (/info,
+   /echo, API answers) and responses that say "Cache-Control:
+   no-store" are compressed but never cached.
+   ============================================ */
+
+#define COMPRESS_MIN_BYTES 1024                 // Smaller bodies go out as they are
+#define COMPRESS_CACHE_ENTRIES 32               // Per worker thread
+#define COMPRESS_CACHE_MAX_BODY (256 * 1024)    // Larger bodies are not cached
+
+typedef enum {
+    CODING_GZIP,
+    CODING_DEFLATE,
+    CODING_COUNT
+} ContentCoding;
+
+static const char *const coding_names[CODING_COUNT] = {"gzip", "deflate"};
+
+// zlib window bits: +16 wraps the stream in a gzip header, plain 15
+// is the zlib format that HTTP calls "deflate"
+static const int coding_window_bits[CODING_COUNT] = {15 + 16, 15};
+
+typedef struct {
+    unsigned long long hash;    // Of the uncompressed body: a quick first check
+    char *body;                 // Copy of the uncompressed body, compared on a hit
+    size_t length;              // Uncompressed length
+    ContentCoding coding;
+    SharedBuffer *data;         // Compressed bytes, NULL if it did not shrink
+    unsigned long long last_used;
+} CompressedEntry;
+
+// Per thread, like the buffer pool and the file cache: no locking
+typedef struct {
+    CompressedEntry entries[COMPRESS_CACHE_ENTRIES];
+    int count;
+    unsigned long long clock;
+    z_stream streams[CODING_COUNT];  // Reused with deflateReset()
+    int stream_ready[CODING_COUNT];
+} CompressCache;
+
+static _Thread_local CompressCache cache;
+
+static const char *const compressible_types[] = {
+    "text/",
+    "application/json",
+    "application/javascript",
+    "application/xml",
+    "image/svg+xml",
+};
+
+static int is_compressible(const char *content_type) {
+    for (size_t i = 0; i < sizeof(compressible_types) / sizeof(compressible_types[0]); i++) {
+        if (strncasecmp(content_type, compressible_types[i], strlen(compressible_types[i])) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 64-bit FNV-1a
+static unsigned long long hash_body(const char *data, size_t length) {
+    unsigned long long h = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        h = (h ^ (unsigned char)data[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+static CompressedEntry *cache_find(unsigned long long hash, const char *body, size_t length,
+                                   ContentCoding coding) {
+    for (int i = 0; i < cache.count; i++) {
+        CompressedEntry *entry = &cache.entries[i];
+        if (entry->hash == hash && entry->length == length && entry->coding == coding &&
+            memcmp(entry->body, body, length) == 0) {
+            entry->last_used = ++cache.clock;
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+// Keep a result (taking a reference), evicting the least recently used entry
+static void cache_store(unsigned long long hash, const char *body, size_t length,
+                        ContentCoding coding, SharedBuffer *data) {
+    char *copy = malloc(length);
+    if (!copy) return;  // Just not cached
+    memcpy(copy, body, length);
+
+    CompressedEntry *entry = &cache.entries[cache.count];
+    if (cache.count == COMPRESS_CACHE_ENTRIES) {
+        entry = &cache.entries[0];
+        for (int i = 1; i < cache.count; i++) {
+            if (cache.entries[i].last_used < entry->last_used) entry = &cache.entries[i];
+        }
+        shared_buffer_release(entry->data);
+        free(entry->body);
+    } else {
+        cache.count++;
+    }
+
+    if (data) data->refs++;
+    *entry = (CompressedEntry){hash, copy, length, coding, data, ++cache.clock};
+}
+
+// Compress into a new shared buffer; NULL if out of memory or the
+// result would not be smaller
+static SharedBuffer *compress_body(ContentCoding coding, const char *data, size_t length) {
+    z_stream *stream = &cache.streams[coding];
+    if (!cache.stream_ready[coding]) {
+        if (deflateInit2(stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, coding_window_bits[coding],
+                         8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return NULL;
+        }
+        cache.stream_ready[coding] = 1;
+    } else {
+        deflateReset(stream);
+    }
+
+    size_t capacity = deflateBound(stream, length);
+    if (capacity >= length) capacity = length - 1;  // Anything bigger is no use
+    SharedBuffer *out = shared_buffer_create(capacity);
+    if (!out) return NULL;
+
+    stream->next_in = (Bytef *)data;
+    stream->avail_in = (uInt)length;
+    stream->next_out = (Bytef *)out->data;
+    stream->avail_out = (uInt)capacity;
+    if (deflate(stream, Z_FINISH) != Z_STREAM_END) {
+        // Ran out of room: it did not get smaller
+        shared_buffer_release(out);
+        return NULL;
+    }
+
+    // Give back the unused worst-case room; nobody else holds it yet
+    out->length = stream->total_out;
+    SharedBuffer *smaller = realloc(out, sizeof(SharedBuffer) + out->length);
+    return smaller ? smaller : out;
+}
+
+void http_compress_response(const HttpRequest *request, HttpResponse *response) {
+    // Only bodies we hold in memory, and only whole ones
+    if (response->prerendered || !response->body || response->body_mode == BODY_FILE) return;
+    if (response->status_code == 206 || response->body_length < COMPRESS_MIN_BYTES) return;
+    if (!is_compressible(response->content_type)) return;
+    if (strstr(response->headers, "Content-Encoding:")) return;
+
+    // Whether we compress now depends on this header: tell caches
+    http_response_add_header(response, "Vary", "Accept-Encoding");
+
+    HttpStr accept_encoding = http_request_header(request, HDR_ACCEPT_ENCODING);
+    ContentCoding coding;
+    if (http_accepts_encoding(accept_encoding, "gzip")) coding = CODING_GZIP;
+    else if (http_accepts_encoding(accept_encoding, "deflate")) coding = CODING_DEFLATE;
+    else return;
+
+    int cacheable = response->body_cacheable &&
+                    response->body_length <= COMPRESS_CACHE_MAX_BODY &&
+                    !strstr(response->headers, "no-store");
+    unsigned long long hash = 0;
+    SharedBuffer *compressed = NULL;
+
+    CompressedEntry *entry = NULL;
+    if (cacheable) {
+        hash = hash_body(response->body, response->body_length);
+        entry = cache_find(hash, response->body, response->body_length, coding);
+    }
+
+    if (entry) {
+        if (!entry->data) return;  // Known not to shrink
+        compressed = entry->data;
+        compressed->refs++;
+        printf("[COMPRESS] %s %zu -> %zu bytes (cached)\n", coding_names[coding],
+               response->body_length, compressed->length);
+    } else {
+        compressed = compress_body(coding, response->body, response->body_length);
+        if (cacheable) {
+            cache_store(hash, response->body, response->body_length, coding, compressed);
+        }
+        if (!compressed) return;
+        printf("[COMPRESS] %s %zu -> %zu bytes\n", coding_names[coding],
+               response->body_length, compressed->length);
+    }
+
+    http_response_release_body(response);
+    http_response_set_shared(response, compressed);
+    http_response_add_header(response, "Content-Encoding", coding_names[coding]);
+}
+
+void compress_cache_trim(void) {
+    for (int i = 0; i < cache.count; i++) {
+        shared_buffer_release(cache.entries[i].data);
+        free(cache.entries[i].body);
+    }
+    cache.count = 0;
+    for (int i = 0; i < CODING_COUNT; i++) {
+        if (cache.stream_ready[i]) deflateEnd(&cache.streams[i]);
+        cache.stream_ready[i] = 0;
+    }
+}
@@ -0,0 +1,375 @@
+#define _POSIX_C_SOURCE 200809L
+#include "http_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+
+/* ============================================
+   NON-BLOCKING CONNECTION I/O
+   ============================================
+   With a blocking socket, recv() waits until data arrives and
+   send() waits until the kernel has room. That is simple, but a
+   single slow client then stalls the whole server.
+
+   A non-blocking socket returns immediately instead:
+   - recv() returns -1 with errno EAGAIN when nothing is buffered
+   - send() returns fewer bytes than asked (or EAGAIN) when the
+     kernel send buffer is full
+
+   So each connection keeps its own buffers, and the event loop
+   calls back in here whenever epoll says the socket is ready again.
+   ============================================ */
+
+// Free (or close, or release) whatever a sent or dropped segment owns
+static void release_segment(OutputSegment *segment) {
+    free(segment->owned);
+    shared_buffer_release(segment->shared);
+    if (segment->file) file_cache_release(segment->file);
+    else if (segment->fd >= 0) close(segment->fd);
+}
+
+Connection *connection_create(int fd, const char *client_ip) {
+    Connection *conn = calloc(1, sizeof(Connection));
+    if (!conn) return NULL;
+
+    // No read buffer yet: one is borrowed from the pool on the first read
+    http_parser_init(&conn->parser);
+
+    conn->fd = fd;
+    strncpy(conn->client_ip, client_ip, sizeof(conn->client_ip) - 1);
+    return conn;
+}
+
+void connection_destroy(Connection *conn) {
+    /* ============================================
+       CLOSE CLIENT CONNECTION
+       ============================================
+       close() terminates the connection:
+       1. Sends TCP FIN packet to client
+       2. Releases the socket resources
+       3. Client receives FIN and closes their end
+
+       Closing the fd also removes it from every epoll set.
+       ============================================ */
+    close(conn->fd);
+    http_request_reset(&conn->request);
+    buffer_pool_release(conn->read_buffer, conn->read_capacity);
+    for (size_t i = conn->output_head; i < conn->output_count; i++) {
+        release_segment(&conn->output[i]);
+    }
+    free(conn->output);
+    arena_reset(&conn->arena);
+    free(conn);
+}
+
+int connection_reserve_read(Connection *conn, size_t extra) {
+    size_t needed = conn->read_length + extra + 1;  // +1 for the NUL terminator
+    if (needed <= conn->read_capacity) return 0;
+    if (needed > MAX_READ_BUFFER) return -1;
+
+    // At least double, so a big upload is copied only a few times
+    size_t size = conn->read_capacity * 2;
+    if (size < needed) size = needed;
+    if (size > MAX_READ_BUFFER) size = MAX_READ_BUFFER;
+
+    size_t capacity;
+    char *buffer = buffer_pool_acquire(size, &capacity);
+    if (!buffer) return -1;
+
+    if (conn->read_buffer) {
+        memcpy(buffer, conn->read_buffer, conn->read_length + 1);
+        buffer_pool_release(conn->read_buffer, conn->read_capacity);
+    } else {
+        buffer[0] = '\0';
+    }
+    conn->read_buffer = buffer;
+    conn->read_capacity = capacity;
+    return 0;
+}
+
+void connection_release_read(Connection *conn) {
+    if (!conn->read_buffer || conn->read_length > 0) return;
+
+    buffer_pool_release(conn->read_buffer, conn->read_capacity);
+    conn->read_buffer = NULL;
+    conn->read_capacity = 0;
+}
+
+int connection_read(Connection *conn) {
+    /* ============================================
+       READ UNTIL THE KERNEL BUFFER IS EMPTY
+       ============================================
+       The event loop uses edge-triggered epoll: it only reports a
+       socket again when NEW data arrives. So we must keep calling
+       recv() until it says EAGAIN, or leftover bytes would sit in
+       the kernel with nobody coming back for them.
+
+       The buffer starts small (4KB from the pool) and a large upload
+       grows it, doubling, up to MAX_READ_BUFFER. If even that is full
+       we stop early and set read_full, telling the event loop to come
+       back once the parser has consumed some of it.
+       ============================================ */
+    conn->read_full = 0;
+
+    for (;;) {
+        if (conn->read_length + 1 >= conn->read_capacity) {
+            if (connection_reserve_read(conn, 1) < 0) {
+                conn->read_full = 1;
+                return 1;
+            }
+        }
+
+        size_t space = conn->read_capacity - 1 - conn->read_length;
+        ssize_t n = recv(conn->fd, conn->read_buffer + conn->read_length, space, 0);
+        if (n > 0) {
+            conn->read_length += n;
+            conn->read_buffer[conn->read_length] = '\0';
+            continue;
+        }
+
+        if (n == 0) {
+            return 0;  // Peer sent FIN
+        }
+
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return 1;
+
+        perror("[ERROR] Failed to receive data");
+        return -1;
+    }
+}
+
+int connection_has_pending_output(const Connection *conn) {
+    return conn->output_head < conn->output_count;
+}
+
+int connection_finished(const Connection *conn) {
+    return conn->close_after_write && !conn->stream;
+}
+
+// Append a segment, releasing what it owns if there is no room for it
+static int queue_segment(Connection *conn, OutputSegment segment) {
+    if (conn->output_count == conn->output_capacity) {
+        size_t capacity = conn->output_capacity ? conn->output_capacity * 2 : 8;
+        OutputSegment *output = realloc(conn->output, capacity * sizeof(OutputSegment));
+        if (!output) {
+            release_segment(&segment);
+            return -1;
+        }
+        conn->output = output;
+        conn->output_capacity = capacity;
+    }
+
+    conn->output[conn->output_count++] = segment;
+    return 0;
+}
+
+int connection_queue_output(Connection *conn, const char *data, size_t length, void *owned) {
+    if (length == 0) {
+        free(owned);
+        return 0;
+    }
+    return queue_segment(conn, (OutputSegment){data, length, owned, -1, 0, NULL, NULL});
+}
+
+int connection_queue_shared(Connection *conn, SharedBuffer *buffer) {
+    OutputSegment segment = {buffer->data, buffer->length, NULL, -1, 0, NULL, buffer};
+    if (buffer->length == 0) {
+        release_segment(&segment);
+        return 0;
+    }
+    return queue_segment(conn, segment);
+}
+
+int connection_queue_file(Connection *conn, int fd, off_t offset, size_t length,
+                          CachedFile *file) {
+    OutputSegment segment = {NULL, length, NULL, fd, offset, file, NULL};
+    if (length == 0) {
+        release_segment(&segment);
+        return 0;
+    }
+    return queue_segment(conn, segment);
+}
+
+int connection_output_is_file(const Connection *conn) {
+    return connection_has_pending_output(conn) && conn->output[conn->output_head].fd >= 0;
+}
+
+size_t connection_output_iov(const Connection *conn, struct iovec *iov, size_t max) {
+    size_t n = 0;
+    for (size_t i = conn->output_head; i < conn->output_count && n < max; i++, n++) {
+        if (conn->output[i].fd >= 0) break;  // sendfile() takes it from here
+        iov[n].iov_base = (void *)conn->output[i].data;
+        iov[n].iov_len = conn->output[i].length;
+    }
+    return n;
+}
+
+void connection_advance_output(Connection *conn, size_t sent) {
+    conn->output_sent += sent;
+
+    // Drop every segment the kernel took completely; trim the one it
+    // stopped in the middle of
+    while (sent > 0 && connection_has_pending_output(conn)) {
+        OutputSegment *segment = &conn->output[conn->output_head];
+        if (sent < segment->length) {
+            if (segment->fd >= 0) segment->offset += sent;
+            else segment->data += sent;
+            segment->length -= sent;
+            return;
+        }
+        sent -= segment->length;
+        release_segment(segment);
+        conn->output_head++;
+    }
+
+    if (connection_has_pending_output(conn)) {
+        return;
+    }
+
+    printf("[RESPONSE] Sent %zu bytes total\n", conn->output_sent);
+    conn->output_head = 0;
+    conn->output_count = 0;
+    conn->output_sent = 0;
+}
+
+int connection_send_file(Connection *conn) {
+    /* ============================================
+       ZERO-COPY FILE SENDING
+       ============================================
+       Sending a file the obvious way means read() - copying it from
+       the kernel's page cache into our memory - and then send() -
+       copying it straight back into the kernel's socket buffer. The
+       bytes cross into user space only to be handed back unchanged,
+       and the whole file has to fit in our memory first.
+
+       sendfile() asks the kernel to move the bytes from the file to
+       the socket itself. We never allocate a buffer for them, so an
+       image download costs the same few bytes of memory whether the
+       file is 10KB or 10GB.
+       ============================================ */
+    while (connection_output_is_file(conn)) {
+        OutputSegment *segment = &conn->output[conn->output_head];
+        off_t offset = segment->offset;
+        ssize_t sent = sendfile(conn->fd, segment->fd, &offset, segment->length);
+        if (sent > 0) {
+            size_t length = segment->length;
+            connection_advance_output(conn, sent);
+            if ((size_t)sent == length) return 1;
+            continue;
+        }
+
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return 0;
+        }
+
+        // sent == 0: the file is shorter than when the response was built
+        perror("[ERROR] Failed to send file");
+        return -1;
+    }
+    return 1;
+}
+
+int connection_flush(Connection *conn) {
+    /* ============================================
+       GATHER WRITE
+       ============================================
+       A response is several separate pieces of memory: the status
+       line and headers we just formatted, then the body the handler
+       built. Copying them into one buffer first would cost a memcpy
+       of the whole body; sending them one send() each would cost a
+       system call (and often a TCP packet) per piece.
+
+       sendmsg() takes an array of (pointer, length) pairs - an
+       iovec - and sends them as one contiguous stream in a single
+       call. A small response leaves in one packet.
+
+       The socket may accept only part of it. Whatever is left stays
+       queued (segment by segment) and we resume on the next EPOLLOUT
+       instead of blocking the thread.
+       ============================================ */
+    while (connection_has_pending_output(conn)) {
+        if (connection_output_is_file(conn)) {
+            int status = connection_send_file(conn);
+            if (status <= 0) return status;
+            continue;
+        }
+
+        struct iovec iov[OUTPUT_IOV_MAX];
+        struct msghdr msg = {0};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = connection_output_iov(conn, iov, OUTPUT_IOV_MAX);
+
+        // Headers followed by a file: MSG_MORE holds the headers back so
+        // they share a packet with the first file bytes
+        size_t next = conn->output_head + msg.msg_iovlen;
+        int flags = MSG_NOSIGNAL;
+        if (next < conn->output_count && conn->output[next].fd >= 0) flags |= MSG_MORE;
+
+        ssize_t sent = sendmsg(conn->fd, &msg, flags);
+        if (sent > 0) {
+            connection_advance_output(conn, sent);
+            continue;
+        }
+
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Kernel send buffer is full - wait for EPOLLOUT
+            return 0;
+        }
+
+        perror("[ERROR] Failed to send response");
+        return -1;
+    }
+
+    return 1;
+}
+
+void connection_list_add(ConnectionList *list, Connection *conn) {
+    conn->next = NULL;
+    conn->prev = list->tail;
+    if (list->tail) list->tail->next = conn;
+    else list->head = conn;
+    list->tail = conn;
+    conn->last_active_ms = connection_now_ms();
+}
+
+void connection_list_remove(ConnectionList *list, Connection *conn) {
+    if (conn->prev) conn->prev->next = conn->next;
+    else list->head = conn->next;
+    if (conn->next) conn->next->prev = conn->prev;
+    else list->tail = conn->prev;
+    conn->prev = NULL;
+    conn->next = NULL;
+}
+
+void connection_list_touch(ConnectionList *list, Connection *conn) {
+    /* ============================================
+       IDLE TRACKING IN O(1)
+       ============================================
+       Moving a connection to the tail on every bit of activity keeps
+       the list sorted by last activity. Finding connections that have
+       been idle too long then means looking at the head only, instead
+       of scanning every client on every loop iteration.
+       ============================================ */
+    conn->last_active_ms = connection_now_ms();
+    if (list->tail == conn) return;
+
+    connection_list_remove(list, conn);
+    conn->prev = list->tail;
+    if (list->tail) list->tail->next = conn;
+    else list->head = conn;
+    list->tail = conn;
+}
+
+long long connection_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,155 @@
+#include "http_server.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/* ============================================
+   REQUEST HEADERS
+   ============================================
+   A browser sends 10-20 headers with every request. Handlers
+   care about a few well-known ones (Host, Accept-Encoding,
+   If-None-Match, ...), and asking for one by comparing names
+   against every header would cost a loop of string compares each
+   time.
+
+   Instead, each header is tagged with an id as it is parsed, and
+   the request keeps a small table: known[HDR_HOST] says where the
+   Host header is. A lookup is then a single array index.
+
+   Finding the id of a name has to be cheap too, since it runs for
+   every header of every request. A "perfect hash" does it with one
+   probe: a formula over the name's length and three of its letters
+   that gives every known header its own slot, so there is no
+   collision chain to walk. One case-insensitive compare confirms
+   the slot really holds this name.
+   ============================================ */
+
+#define HEADER_SLOTS 64
+
+typedef struct {
+    HttpHeaderId id;
+    const char *name;
+    size_t len;
+} KnownHeader;
+
+// ASCII letters only differ in bit 0x20 between cases; '-' and digits
+// already have it set, so OR-ing it in folds case for every byte we hash
+static unsigned header_hash(const char *name, size_t len) {
+    unsigned first = (unsigned char)name[0] | 0x20;
+    unsigned middle = (unsigned char)name[len / 2] | 0x20;
+    unsigned last = (unsigned char)name[len - 1] | 0x20;
+    return (unsigned)(len * 47 + first * 25 + last * 47 + middle) & (HEADER_SLOTS - 1);
+}
+
+// Indexed by header_hash(name). The multipliers above were found by a
+// brute-force search for values that leave no two names in one slot;
+// adding a header means re-running that search.
+static const KnownHeader known_headers[HEADER_SLOTS] = {
+    [0] = {HDR_PRAGMA, "Pragma", 6},
+    [2] = {HDR_CONTENT_LENGTH, "Content-Length", 14},
+    [4] = {HDR_ACCEPT, "Accept", 6},
+    [5] = {HDR_CACHE_CONTROL, "Cache-Control", 13},
+    [6] = {HDR_RANGE, "Range", 5},
+    [8] = {HDR_ACCEPT_ENCODING, "Accept-Encoding", 15},
+    [9] = {HDR_TRANSFER_ENCODING, "Transfer-Encoding", 17},
+    [10] = {HDR_ORIGIN, "Origin", 6},
+    [11] = {HDR_VIA, "Via", 3},
+    [16] = {HDR_X_REAL_IP, "X-Real-IP", 9},
+    [20] = {HDR_IF_MODIFIED_SINCE, "If-Modified-Since", 17},
+    [22] = {HDR_CONNECTION, "Connection", 10},
+    [25] = {HDR_X_FORWARDED_FOR, "X-Forwarded-For", 15},
+    [26] = {HDR_FORWARDED, "Forwarded", 9},
+    [28] = {HDR_X_FORWARDED_PROTO, "X-Forwarded-Proto", 17},
+    [30] = {HDR_CONTENT_TYPE, "Content-Type", 12},
+    [33] = {HDR_IF_NONE_MATCH, "If-None-Match", 13},
+    [34] = {HDR_TE, "TE", 2},
+    [35] = {HDR_HOST, "Host", 4},
+    [36] = {HDR_FROM, "From", 4},
+    [37] = {HDR_IF_RANGE, "If-Range", 8},
+    [40] = {HDR_EXPECT, "Expect", 6},
+    [41] = {HDR_CONTENT_ENCODING, "Content-Encoding", 16},
+    [47] = {HDR_IF_UNMODIFIED_SINCE, "If-Unmodified-Since", 19},
+    [48] = {HDR_USER_AGENT, "User-Agent", 10},
+    [49] = {HDR_ACCEPT_LANGUAGE, "Accept-Language", 15},
+    [50] = {HDR_IF_MATCH, "If-Match", 8},
+    [51] = {HDR_UPGRADE, "Upgrade", 7},
+    [52] = {HDR_X_REQUESTED_WITH, "X-Requested-With", 16},
+    [53] = {HDR_KEEP_ALIVE, "Keep-Alive", 10},
+    [55] = {HDR_AUTHORIZATION, "Authorization", 13},
+    [58] = {HDR_ACCEPT_CHARSET, "Accept-Charset", 14},
+    [59] = {HDR_COOKIE, "Cookie", 6},
+    [62] = {HDR_REFERER, "Referer", 7},
+    [63] = {HDR_DATE, "Date", 4},
+};
+
+HttpHeaderId http_header_id(const char *name, size_t len) {
+    if (len == 0) return HDR_UNKNOWN;
+
+    const KnownHeader *slot = &known_headers[header_hash(name, len)];
+    if (slot->len == len && strncasecmp(slot->name, name, len) == 0) {
+        return slot->id;
+    }
+    return HDR_UNKNOWN;
+}
+
+int http_request_add_header(HttpRequest *request, HttpStr name, HttpStr value) {
+    size_t index = request->header_count;
+    if (index >= HTTP_MAX_HEADERS) return -1;
+
+    HttpHeader *header;
+    if (index < HTTP_INLINE_HEADERS) {
+        header = &request->headers[index];
+    } else {
+        // Unusually many headers: spill over into a heap array
+        size_t extra = index - HTTP_INLINE_HEADERS;
+        if (extra == request->extra_capacity) {
+            size_t capacity = request->extra_capacity ? request->extra_capacity * 2 : 16;
+            HttpHeader *grown = realloc(request->extra_headers, capacity * sizeof(HttpHeader));
+            if (!grown) return -1;
+            request->extra_headers = grown;
+            request->extra_capacity = capacity;
+        }
+        header = &request->extra_headers[extra];
+    }
+
+    header->name = name;
+    header->value = value;
+    header->id = http_header_id(name.ptr, name.len);
+    request->header_count++;
+
+    // Remember the first occurrence of each known header
+    if (header->id != HDR_UNKNOWN && !request->known[header->id]) {
+        request->known[header->id] = (unsigned char)(index + 1);
+    }
+    return 0;
+}
+
+const HttpHeader *http_request_header_at(const HttpRequest *request, size_t i) {
+    if (i < HTTP_INLINE_HEADERS) return &request->headers[i];
+    return &request->extra_headers[i - HTTP_INLINE_HEADERS];
+}
+
+HttpStr http_request_header(const HttpRequest *request, HttpHeaderId id) {
+    unsigned index = request->known[id];
+    if (!index) return (HttpStr){NULL, 0};
+    return http_request_header_at(request, index - 1)->value;
+}
+
+void http_request_reset(HttpRequest *request) {
+    // The views need no cleanup; only the overflow array is ours. The
+    // inline header slots are simply overwritten by the next request.
+    free(request->extra_headers);
+    request->extra_headers = NULL;
+    request->extra_capacity = 0;
+
+    request->method = HTTP_UNKNOWN;
+    request->method_name = (HttpStr){NULL, 0};
+    request->http_minor = 0;
+    request->keep_alive = 0;
+    request->path = (HttpStr){NULL, 0};
+    request->query = (HttpStr){NULL, 0};
+    request->header_count = 0;
+    memset(request->known, 0, sizeof(request->known));
+    request->body = (HttpStr){NULL, 0};
+    request->client_ip[0] = '\0';
+}
@@ -1,5 +1,7 @@
 #define _POSIX_C_SOURCE 200809L
 #include "http_server.h"
+#include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,8 +10,6 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 
-#define BUFFER_SIZE 65536 // 64KB buffer for requests
-
 /* ============================================
    HTTP PROTOCOL EXPLANATION
    ============================================
@@ -48,7 +48,380 @@
 
    ============================================ */
 
-void send_http_response(int client_fd, const HttpResponse *response)
+const char *http_status_message(int status_code)
+{
+    switch (status_code)
+    {
+    case 200:
+        return "OK";
+    case 201:
+        return "Created";
+    case 206:
+        return "Partial Content";
+    case 304:
+        return "Not Modified";
+    case 400:
+        return "Bad Request";
+    case 401:
+        return "Unauthorized";
+    case 404:
+        return "Not Found";
+    case 413:
+        return "Payload Too Large";
+    case 414:
+        return "URI Too Long";
+    case 416:
+        return "Range Not Satisfiable";
+    case 431:
+        return "Request Header Fields Too Large";
+    case 500:
+        return "Internal Server Error";
+    case 501:
+        return "Not Implemented";
+    case 502:
+        return "Bad Gateway";
+    default:
+        return "Unknown";
+    }
+}
+
+/* ============================================
+   MULTIPART/BYTERANGES
+   ============================================
+   A request for several ranges of a file is answered with one body
+   holding all of them, each introduced by a boundary line and its
+   own headers:
+
+   --3d6b6a416f9b5        <- boundary (also in the Content-Type)
+   Content-Type: video/mp4
+   Content-Range: bytes 0-99/5000
+
+   <bytes 0-99 of the file>
+   --3d6b6a416f9b5
+   Content-Range: bytes 4900-4999/5000 ...
+   --3d6b6a416f9b5--      <- closing boundary
+
+   Only this framing text is built in memory; the ranges themselves
+   are still sent from the file with sendfile().
+   ============================================ */
+
+// Fill parts[] with the framing before each range plus the closing
+// boundary (all malloc()ed), and set *body_len to the total body size.
+// Returns the number of parts (range_count + 1), or 0 if out of memory.
+static size_t format_byteranges(const HttpResponse *response, char *boundary,
+                                char **parts, size_t *body_len)
+{
+    // Random-looking and unlikely to occur inside the file
+    static _Thread_local unsigned long long counter;
+    unsigned long long seed = ((unsigned long long)connection_now_ms() << 16) ^
+                              (unsigned long long)(uintptr_t)response ^ ++counter;
+    snprintf(boundary, 24, "%016llx", seed * 0x9E3779B97F4A7C15ULL);
+
+    size_t count = response->range_count;
+    size_t file_size = response->body_file->size;
+    *body_len = 0;
+
+    for (size_t i = 0; i <= count; i++)
+    {
+        char part[320];
+        if (i < count)
+        {
+            const HttpRange *range = &response->ranges[i];
+            snprintf(part, sizeof(part),
+                     "\r\n--%s\r\n"
+                     "Content-Type: %s\r\n"
+                     "Content-Range: bytes %lld-%lld/%zu\r\n"
+                     "\r\n",
+                     boundary, response->content_type, (long long)range->offset,
+                     (long long)range->offset + (long long)range->length - 1, file_size);
+            *body_len += range->length;
+        }
+        else
+        {
+            snprintf(part, sizeof(part), "\r\n--%s--\r\n", boundary);
+        }
+
+        parts[i] = strdup(part);
+        if (!parts[i])
+        {
+            while (i > 0)
+            {
+                free(parts[--i]);
+            }
+            return 0;
+        }
+        *body_len += strlen(part);
+    }
+    return count + 1;
+}
+
+// Status line and headers, up to and including the blank line
+static int format_head(char *out, size_t size, const HttpResponse *response,
+                       const char *content_type, size_t body_len, int close_connection)
+{
+    // A 304 has no body, and no Content-Length: the client keeps using
+    // the copy it already has. A streamed body's length is not known
+    // yet: it comes in chunks, or (when closing anyway) ends at the close.
+    char length_line[48] = "";
+    if (response->stream)
+    {
+        if (!close_connection)
+        {
+            snprintf(length_line, sizeof(length_line), "Transfer-Encoding: chunked\r\n");
+        }
+    }
+    else if (response->status_code != 304)
+    {
+        snprintf(length_line, sizeof(length_line), "Content-Length: %zu\r\n", body_len);
+    }
+
+    return snprintf(out, size,
+                    "HTTP/1.1 %d %s\r\n"
+                    "Content-Type: %s\r\n"
+                    "%s"
+                    "%s"
+                    "Connection: %s\r\n"
+                    "\r\n",
+                    response->status_code,
+                    http_status_message(response->status_code),
+                    content_type,
+                    length_line,
+                    response->headers,
+                    close_connection ? "close" : "keep-alive");
+}
+
+char *http_serialize_response(const HttpResponse *response, int close_connection,
+                              size_t *length)
+{
+    size_t body_len = response->body ? response->body_length : 0;
+    char headers[1024];
+    int header_len = format_head(headers, sizeof(headers), response, response->content_type,
+                                 body_len, close_connection);
+
+    char *bytes = malloc(header_len + body_len);
+    if (!bytes)
+    {
+        return NULL;
+    }
+    memcpy(bytes, headers, header_len);
+    if (body_len)
+    {
+        memcpy(bytes + header_len, response->body, body_len);
+    }
+    *length = header_len + body_len;
+    return bytes;
+}
+
+/* ============================================
+   STREAMED RESPONSES (CHUNKED TRANSFER ENCODING)
+   ============================================
+   Content-Length must be sent before the body, so normally the whole
+   body has to be built first - in memory, all of it - before the
+   first byte can leave. A big page costs a big buffer, and the
+   client sees nothing until it is done.
+
+   A streamed response sends the headers right away and produces the
+   body piece by piece: the handler's stream function writes the next
+   piece each time the previous one has been sent. Each piece goes
+   out as a chunk, prefixed with its size in hex:
+
+   HTTP/1.1 200 OK
+   Transfer-Encoding: chunked
+
+   1a\r\n
+   <26 bytes>\r\n
+   400\r\n
+   <1024 bytes>\r\n
+   0\r\n                 <- a zero-size chunk ends the body
+   \r\n
+
+   Only one piece is in memory at a time, however large the body.
+
+   HTTP/1.0 clients do not know chunks: they get the raw body and the
+   connection is closed to mark its end.
+   ============================================ */
+
+#define STREAM_CHUNK_HEADROOM 20   // "%zx\r\n" for any size_t
+#define STREAM_PIECE_SIZE 4096     // Initial room for one piece
+
+static const char last_chunk[] = "0\r\n\r\n";
+
+void http_response_stream(HttpResponse *response, HttpStreamFn fn, void *state)
+{
+    response->stream = fn;
+    response->stream_state = state;
+}
+
+// Make room for `extra` more bytes (plus the chunk's trailing CRLF)
+static int writer_reserve(HttpWriter *writer, size_t extra)
+{
+    if (writer->failed)
+    {
+        return -1;
+    }
+    size_t used = writer->length ? writer->length : STREAM_CHUNK_HEADROOM;
+    size_t needed = used + extra + 2;
+    if (needed <= writer->capacity)
+    {
+        writer->length = used;
+        return 0;
+    }
+
+    size_t capacity = writer->capacity ? writer->capacity * 2 : STREAM_PIECE_SIZE;
+    while (capacity < needed)
+    {
+        capacity *= 2;
+    }
+    char *buffer = arena_grow(writer->arena, writer->buffer, writer->capacity, capacity);
+    if (!buffer)
+    {
+        writer->failed = 1;
+        return -1;
+    }
+    writer->buffer = buffer;
+    writer->capacity = capacity;
+    writer->length = used;
+    return 0;
+}
+
+void http_writer_write(HttpWriter *writer, const char *data, size_t length)
+{
+    if (length == 0 || writer_reserve(writer, length) < 0)
+    {
+        return;
+    }
+    memcpy(writer->buffer + writer->length, data, length);
+    writer->length += length;
+}
+
+void http_writer_printf(HttpWriter *writer, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (n <= 0 || writer_reserve(writer, (size_t)n + 1) < 0)
+    {
+        return;
+    }
+
+    va_start(args, format);
+    vsnprintf(writer->buffer + writer->length, (size_t)n + 1, format, args);
+    va_end(args);
+    writer->length += n;
+}
+
+// The stream is over (or aborted): forget it. Its state and buffer
+// are in the arena, which is reset once the last piece has left.
+static void end_stream(Connection *conn)
+{
+    conn->stream = NULL;
+    conn->stream_state = NULL;
+    memset(&conn->stream_writer, 0, sizeof(conn->stream_writer));
+}
+
+// Have the stream write its next piece and queue it
+static void pump_stream(Connection *conn)
+{
+    // The previous piece has been sent, so its buffer can take the next.
+    // A call that wrote nothing would leave nothing to send - and so
+    // nothing to call us back for the next piece.
+    HttpWriter *writer = &conn->stream_writer;
+    writer->length = 0;
+    int more;
+    do
+    {
+        more = conn->stream(writer, conn->stream_state);
+    } while (more > 0 && writer->length == 0 && !writer->failed);
+
+    if (writer->failed)
+    {
+        fprintf(stderr, "[ERROR] Out of memory streaming response\n");
+        more = -1;
+    }
+
+    size_t length = writer->length ? writer->length - STREAM_CHUNK_HEADROOM : 0;
+    if (length > 0 && more >= 0)
+    {
+        // The size line goes right in front of the data, the CRLF after
+        // it, so the whole chunk is one segment
+        char *start = writer->buffer + STREAM_CHUNK_HEADROOM;
+        if (conn->stream_chunked)
+        {
+            char size_line[STREAM_CHUNK_HEADROOM + 1];
+            int n = snprintf(size_line, sizeof(size_line), "%zx\r\n", length);
+            start -= n;
+            memcpy(start, size_line, n);
+            memcpy(writer->buffer + writer->length, "\r\n", 2);
+            length += n + 2;
+        }
+        if (connection_queue_output(conn, start, length, NULL) < 0)
+        {
+            more = -1;
+        }
+    }
+
+    if (more < 0)
+    {
+        // Part of the body is already on its way: the only way left to
+        // tell the client it is incomplete is to hang up without the
+        // final chunk
+        conn->close_after_write = 1;
+        end_stream(conn);
+    }
+    else if (more == 0)
+    {
+        if (conn->stream_chunked &&
+            connection_queue_output(conn, last_chunk, sizeof(last_chunk) - 1, NULL) < 0)
+        {
+            conn->close_after_write = 1;
+        }
+        end_stream(conn);
+    }
+}
+
+// Queue the headers of a streamed response and its first piece
+static void send_stream_head(Connection *conn, HttpResponse *response)
+{
+    char headers[1024];
+    int header_len = format_head(headers, sizeof(headers), response, response->content_type, 0,
+                                 conn->close_after_write);
+
+    printf("[RESPONSE] Sending %d %s\n", response->status_code,
+           http_status_message(response->status_code));
+    printf("[RESPONSE] Content-Type: %s\n", response->content_type);
+    printf("[RESPONSE] Body streamed (%s)\n", conn->close_after_write ? "until close" : "chunked");
+
+    conn->stream = response->stream;
+    conn->stream_state = response->stream_state;
+    conn->stream_chunked = !conn->close_after_write;
+    memset(&conn->stream_writer, 0, sizeof(conn->stream_writer));
+    conn->stream_writer.arena = &conn->arena;
+    response->stream = NULL;
+    response->stream_state = NULL;
+
+    char *header_copy = arena_alloc(&conn->arena, header_len);
+    if (!header_copy)
+    {
+        fprintf(stderr, "[ERROR] Out of memory queueing response\n");
+        conn->close_after_write = 1;
+        end_stream(conn);
+        return;
+    }
+    memcpy(header_copy, headers, header_len);
+    if (connection_queue_output(conn, header_copy, header_len, NULL) < 0)
+    {
+        fprintf(stderr, "[ERROR] Out of memory queueing response\n");
+        conn->close_after_write = 1;
+        end_stream(conn);
+        return;
+    }
+
+    // Headers and first piece leave together
+    pump_stream(conn);
+}
+
+void send_http_response(Connection *conn, HttpResponse *response)
 {
     /* ============================================
        BUILD HTTP RESPONSE
@@ -61,47 +434,78 @@ void send_http_response(int client_fd, const HttpResponse *response)
        BODY
        ============================================ */
 
-    // Status line
-    const char *status_message;
-    switch (response->status_code)
+    if (response->prerendered)
     {
-    case 200:
-        status_message = "OK";
-        break;
-    case 404:
-        status_message = "Not Found";
-        break;
-    case 500:
-        status_message = "Internal Server Error";
-        break;
-    default:
-        status_message = "Unknown";
-        break;
+        // Built at startup: one segment, nothing to format or copy
+        const PrerenderedResponse *prerendered = response->prerendered;
+        const char *bytes = conn->close_after_write ? prerendered->close : prerendered->keep_alive;
+        size_t length = conn->close_after_write ? prerendered->close_length
+                                                : prerendered->keep_alive_length;
+        printf("[RESPONSE] Sending prerendered response (%zu bytes)\n", length);
+        if (connection_queue_output(conn, bytes, length, NULL) < 0)
+        {
+            fprintf(stderr, "[ERROR] Out of memory queueing response\n");
+            conn->close_after_write = 1;
+        }
+        return;
+    }
+
+    if (response->stream)
+    {
+        send_stream_head(conn, response);
+        return;
+    }
+
+    int file_body = response->body_mode == BODY_FILE;
+    int body_fd = file_body ? response->body_fd : -1;
+    CachedFile *body_file = file_body ? response->body_file : NULL;
+    size_t body_len = (response->body || file_body) ? response->body_length : 0;
+
+    // Several ranges of a file: the body is multipart/byteranges, and
+    // its Content-Type names the boundary between the parts
+    const char *content_type = response->content_type;
+    char multipart_type[64];
+    char *parts[HTTP_MAX_RANGES + 1];
+    size_t part_count = 0;
+    if (response->range_count > 1 && body_file)
+    {
+        char boundary[24];
+        part_count = format_byteranges(response, boundary, parts, &body_len);
+        if (part_count > 0)
+        {
+            snprintf(multipart_type, sizeof(multipart_type),
+                     "multipart/byteranges; boundary=%s", boundary);
+            content_type = multipart_type;
+        }
+        else
+        {
+            // Out of memory: send the whole file instead
+            response->status_code = 200;
+            body_len = response->body_length;
+        }
     }
 
     // Build headers
+    const char *status_message = http_status_message(response->status_code);
     char headers[1024];
-    int header_len = snprintf(headers, sizeof(headers),
-                              "HTTP/1.1 %d %s\r\n"
-                              "Content-Type: %s\r\n"
-                              "Content-Length: %zu\r\n"
-                              "Connection: close\r\n"
-                              "\r\n",
-                              response->status_code,
-                              status_message,
-                              response->content_type,
-                              response->body_length);
+    int header_len = format_head(headers, sizeof(headers), response, content_type, body_len,
+                                 conn->close_after_write);
 
     printf("[RESPONSE] Sending %d %s\n", response->status_code, status_message);
     printf("[RESPONSE] Content-Type: %s\n", response->content_type);
-    printf("[RESPONSE] Content-Length: %zu bytes\n", response->body_length);
+    printf("[RESPONSE] Content-Length: %zu bytes\n", body_len);
 
     /* ============================================
-       SEND DATA THROUGH SOCKET
+       QUEUE DATA FOR THE SOCKET
        ============================================
-       send() writes data to the TCP socket
+       The socket is non-blocking, so we cannot simply call send()
+       and assume every byte went out. Instead the headers and body
+       are queued on the connection as two segments, and the event
+       loop sends them - together, in one system call - as the
+       socket becomes writable. The body is queued where the handler
+       left it, not copied.
 
-       What actually happens:
+       What actually happens once the bytes are sent:
        1. Your data is copied to kernel buffer
        2. OS breaks it into TCP segments (MSS ~1460 bytes)
        3. Each segment gets TCP header (ports, sequence numbers)
@@ -116,85 +520,149 @@ void send_http_response(int client_fd, const HttpResponse *response)
 
        The network doesn't care if it's text, JSON, or an image.
        It just moves bytes from point A to point B.
+
+       A file body is queued as a file segment: the event loop later
+       has the kernel copy it to the socket with sendfile(), so the
+       file is never read into our memory at all.
        ============================================ */
 
-    // Send headers
-    ssize_t sent = send(client_fd, headers, header_len, 0);
-    if (sent < 0)
+    // The headers live in the connection's arena until the batch is sent
+    char *header_copy = arena_alloc(&conn->arena, header_len);
+    if (header_copy)
     {
-        perror("[ERROR] Failed to send headers");
-        return;
+        memcpy(header_copy, headers, header_len);
     }
 
-    // Send body (if any)
-    if (response->body && response->body_length > 0)
+    // The queue now owns the body and frees (or closes, or releases) it
+    // once sent. A static body is queued where it lives, uncopied.
+    HttpRange *ranges = response->ranges;
+    response->body_fd = -1;
+    response->body_file = NULL;
+    response->ranges = NULL;
+    response->range_count = 0;
+
+    int queued = header_copy &&
+                 connection_queue_output(conn, header_copy, header_len, NULL) == 0;
+    if (!queued)
     {
-        sent = send(client_fd, response->body, response->body_length, 0);
-        if (sent < 0)
+        http_response_release_body(response);
+        for (size_t i = 0; i < part_count; i++)
         {
-            perror("[ERROR] Failed to send body");
-            return;
+            free(parts[i]);
+        }
+        if (body_file)
+        {
+            file_cache_release(body_file);
+        }
+        else if (body_fd >= 0)
+        {
+            close(body_fd);
+        }
+    }
+    else if (part_count > 0)
+    {
+        // part header, range, part header, range, ..., closing boundary.
+        // Every range segment holds its own reference to the file.
+        for (size_t i = 0; i < part_count; i++)
+        {
+            if (queued)
+            {
+                queued = connection_queue_output(conn, parts[i], strlen(parts[i]), parts[i]) == 0;
+            }
+            else
+            {
+                free(parts[i]);
+            }
+            if (queued && i + 1 < part_count)
+            {
+                body_file->refs++;
+                queued = connection_queue_file(conn, body_fd, ranges[i].offset, ranges[i].length,
+                                               body_file) == 0;
+            }
         }
-        printf("[RESPONSE] Sent %zd bytes total\n", (ssize_t)header_len + sent);
+        file_cache_release(body_file);
+    }
+    else if (file_body)
+    {
+        queued = connection_queue_file(conn, body_fd, response->body_offset, body_len,
+                                       body_file) == 0;
+    }
+    else if (response->body_mode == BODY_SHARED)
+    {
+        queued = connection_queue_shared(conn, response->body_shared) == 0;
     }
     else
     {
-        printf("[RESPONSE] Sent %zd bytes (headers only)\n", sent);
+        void *owned = response->body_mode == BODY_OWNED ? response->body : NULL;
+        queued = connection_queue_output(conn, response->body, body_len, owned) == 0;
     }
-}
+    response->body = NULL;
+    response->body_shared = NULL;
+    response->body_mode = BODY_OWNED;
 
-void handle_client_connection(int client_fd)
-{
-    char buffer[BUFFER_SIZE];
-    ssize_t bytes_received;
-
-    /* ============================================
-      READ DATA FROM SOCKET
-      ============================================
-      recv() reads data from the TCP socket
+    free(ranges);
 
-      What's actually happening:
-      1. Client sends HTTP request as TCP packets
-      2. OS receives packets, reassembles them in order
-      3. Data is buffered in kernel space
-      4. recv() copies data from kernel buffer to your buffer
-
-      The data is just raw bytes. It could be:
-      - ASCII text: "GET / HTTP/1.1"
-      - UTF-8 text: "Hello 世界" (multibyte characters)
-      - Binary: 0xFF 0xD8 0xFF 0xE0... (JPEG image)
+    if (!queued)
+    {
+        fprintf(stderr, "[ERROR] Out of memory queueing response\n");
+        conn->close_after_write = 1;
+    }
+}
 
-      recv() doesn't care what the data means - it just copies bytes.
-      ============================================ */
+void http_response_set_static(HttpResponse *response, const char *body, size_t length)
+{
+    response->body = (char *)body; // Only ever read
+    response->body_length = length;
+    response->body_mode = BODY_STATIC;
+    response->body_cacheable = 1; // Literals and assets never change
+}
 
-    printf("[REQUEST] Reading data from socket...\n");
-    bytes_received = recv(client_fd, buffer, BUFFER_SIZE - 1, 0);
+void http_response_set_shared(HttpResponse *response, SharedBuffer *buffer)
+{
+    response->body = buffer->data;
+    response->body_length = buffer->length;
+    response->body_shared = buffer;
+    response->body_mode = BODY_SHARED;
+}
 
-    if (bytes_received < 0)
+void http_response_release_body(HttpResponse *response)
+{
+    if (response->body_mode == BODY_OWNED)
     {
-        perror("[ERROR] Failed to receive data");
-        return;
+        free(response->body);
     }
-
-    if (bytes_received == 0)
+    else if (response->body_mode == BODY_SHARED)
     {
-        printf("[REQUEST] Client closed connection\n");
-        return;
+        shared_buffer_release(response->body_shared);
     }
+    response->body = NULL;
+    response->body_length = 0;
+    response->body_shared = NULL;
+    response->body_mode = BODY_OWNED;
+    response->body_cacheable = 0;
+}
 
-    buffer[bytes_received] = '\0';
+void http_response_add_header(HttpResponse *response, const char *name, const char *value)
+{
+    size_t used = strlen(response->headers);
+    size_t space = sizeof(response->headers) - used;
+    int n = snprintf(response->headers + used, space, "%s: %s\r\n", name, value);
+    if (n < 0 || (size_t)n >= space)
+    {
+        fprintf(stderr, "[ERROR] No room for response header %s\n", name);
+        response->headers[used] = '\0';
+    }
+}
 
-    printf("[REQUEST] Received %zd bytes\n", bytes_received);
-    printf("[REQUEST] Raw request:\n%s\n", buffer);
+// Route and queue the response for one fully parsed request
+static void dispatch_request(Connection *conn, HttpRequest *request, const char *raw)
+{
+    size_t request_length = conn->parser.pos;
+    printf("[REQUEST] Received %zu bytes\n", request_length);
+    printf("[REQUEST] Raw request:\n%.*s\n", (int)(conn->parser.body_start), raw);
 
-    /* ============================================
-       PARSE HTTP REQUEST
-       ============================================
-       Now we interpret the raw bytes as HTTP protocol
-       ============================================ */
-    HttpRequest request;
-    memset(&request, 0, sizeof(request));
-    parse_http_request(buffer, &request);
+    memcpy(request->client_ip, conn->client_ip, sizeof(request->client_ip));
+    request->arena = &conn->arena;
 
     /* ============================================
         ROUTE REQUEST TO HANDLER
@@ -204,54 +672,193 @@ void handle_client_connection(int client_fd)
         ============================================ */
     HttpResponse response;
     memset(&response, 0, sizeof(response));
-    route_request(&request, &response);
+    response.body_fd = -1;
+    route_request(request, &response);
+    http_compress_response(request, &response);
 
     /* ============================================
     SEND HTTP RESPONSE
     ============================================
     Convert response structure to HTTP format
-    and send bytes back through the socket
+    and queue the bytes on the connection.
+    The connection stays open for the next request
+    unless the client asked otherwise or it has
+    used up its request budget.
     ============================================ */
-    send_http_response(client_fd, &response);
-
-    // Clean up
-    if (request.body)
+    conn->requests_served++;
+    if (!request->keep_alive || conn->requests_served >= server_config.max_requests)
     {
-        free(request.body);
+        conn->close_after_write = 1;
     }
-    if (response.body)
+    if (response.stream && request->http_minor == 0)
     {
-        free(response.body);
+        conn->close_after_write = 1; // No chunks in HTTP/1.0: the close ends the body
     }
+    send_http_response(conn, &response);
 }
 
-void parse_http_request(const char *raw_request, HttpRequest *request)
+// Answer a request the parser rejected, then hang up
+static void reject_request(Connection *conn, int status_code)
 {
-    char *request_copy = strdup(raw_request);
-    char *line = request_copy;
-    char *next_line;
+    const char *message = http_status_message(status_code);
+    HttpResponse response = {
+        .status_code = status_code,
+        .content_type = "text/plain",
+        .body_fd = -1,
+    };
+    http_response_set_static(&response, message, strlen(message));
+
+    printf("[REQUEST] Rejecting malformed request: %d %s\n", status_code, message);
+    conn->close_after_write = 1;
+    send_http_response(conn, &response);
+}
+
+void handle_client_connection(Connection *conn)
+{
+    // A streamed body in progress: write its next piece once the last
+    // one has left. Later requests wait until the stream has ended.
+    if (conn->stream)
+    {
+        if (!connection_has_pending_output(conn))
+        {
+            pump_stream(conn);
+        }
+        return;
+    }
+
+    // A new batch starts only after the previous one has left, and
+    // nothing follows a "close"
+    if (conn->close_after_write || connection_has_pending_output(conn))
+    {
+        return;
+    }
+
+    // Every response so far has been sent: what they were built in can go
+    arena_reset(&conn->arena);
+
+    if (conn->read_length == 0)
+    {
+        connection_release_read(conn); // Nothing to parse yet
+        return;
+    }
 
     /* ============================================
-       PARSE REQUEST LINE
+       PIPELINING
        ============================================
-       First line format: METHOD PATH HTTP_VERSION
-       Example: "GET /index.html HTTP/1.1"
+       An HTTP/1.1 client may send several requests back-to-back
+       without waiting for answers, so one recv() can hold many of
+       them. We answer every complete request in the buffer, in the
+       order received, appending each response to the same write
+       buffer. The whole batch then goes out in a single send().
+
+       The parser keeps its place between calls, so a request that
+       trickles in over many reads is scanned only once overall.
        ============================================ */
+    size_t consumed = 0;
+    int batch = 0;
+
+    while (!conn->close_after_write && !conn->stream)
+    {
+        const char *raw = conn->read_buffer + consumed;
+        HttpParseStatus status = http_parser_execute(&conn->parser, &conn->request,
+                                                     raw, conn->read_length - consumed);
+        if (status == HTTP_PARSE_NEED_MORE)
+        {
+            break; // Wait for more bytes
+        }
+
+        if (status == HTTP_PARSE_ERROR)
+        {
+            reject_request(conn, conn->parser.error_status);
+            break;
+        }
+
+        dispatch_request(conn, &conn->request, raw);
+        consumed += conn->parser.pos;
+        batch++;
+
+        http_request_reset(&conn->request);
+        http_parser_init(&conn->parser);
+    }
+
+    if (batch > 1)
+    {
+        printf("[REQUEST] Answered %d pipelined requests in one batch\n", batch);
+    }
+
+    // Drop the consumed requests; keep any partial bytes of the next one.
+    // The parser's offsets are relative to the start of that partial
+    // request, so they stay valid after the move.
+    if (consumed > 0)
+    {
+        conn->read_length -= consumed;
+        memmove(conn->read_buffer, conn->read_buffer + consumed, conn->read_length);
+        conn->read_buffer[conn->read_length] = '\0';
+    }
+
+    // Everything received has been answered: the connection can wait
+    // for its next request without holding a buffer
+    connection_release_read(conn);
+}
+
+// Case-insensitive search for a whole token in "a, b, c" style values
+static int header_has_token(const char *value, size_t value_len, const char *token)
+{
+    size_t token_len = strlen(token);
+    const char *end_of_value = value + value_len;
+    while (value < end_of_value)
+    {
+        while (value < end_of_value && (*value == ' ' || *value == '\t' || *value == ','))
+            value++;
+        const char *end = value;
+        while (end < end_of_value && *end != ',')
+            end++;
+        const char *trim = end;
+        while (trim > value && (trim[-1] == ' ' || trim[-1] == '\t'))
+            trim--;
+        if ((size_t)(trim - value) == token_len && strncasecmp(value, token, token_len) == 0)
+        {
+            return 1;
+        }
+        value = end;
+    }
+    return 0;
+}
+
+void http_parser_init(HttpParser *parser)
+{
+    memset(parser, 0, sizeof(*parser));
+    parser->state = PARSE_REQUEST_LINE;
+}
+
+static HttpParseStatus parse_error(HttpParser *parser, int status_code)
+{
+    parser->error_status = status_code;
+    return HTTP_PARSE_ERROR;
+}
+
+/* ============================================
+   PARSE REQUEST LINE
+   ============================================
+   First line format: METHOD PATH HTTP_VERSION
+   Example: "GET /index.html HTTP/1.1"
+   ============================================ */
+static HttpParseStatus parse_request_line(HttpParser *parser, HttpRequest *request,
+                                          const char *line, size_t len, const char *method_end)
+{
+    const char *end = line + len;
 
-    // Find end of first line
-    next_line = strstr(line, "\r\n");
-    if (next_line)
+    if (!method_end || method_end == line || method_end >= end)
     {
-        *next_line = '\0';
-        next_line += 2; // Skip \r\n
+        return parse_error(parser, 400);
     }
 
-    // Parse method
-    if (strncmp(line, "GET", 3) == 0)
+    request->method_name = (HttpStr){line, method_end - line};
+    if (http_str_equals(request->method_name, "GET"))
     {
         request->method = HTTP_GET;
     }
-    else if (strncmp(line, "POST", 4) == 0)
+    else if (http_str_equals(request->method_name, "POST"))
     {
         request->method = HTTP_POST;
     }
@@ -260,97 +867,293 @@ void parse_http_request(const char *raw_request, HttpRequest *request)
         request->method = HTTP_UNKNOWN;
     }
 
-    // Parse path
-    char *path_start = strchr(line, ' ');
-    if (path_start)
+    const char *target = method_end + 1;
+    const char *target_end = memchr(target, ' ', end - target);
+    if (!target_end || target_end == target)
+    {
+        return parse_error(parser, 400);
+    }
+    if ((size_t)(target_end - target) > MAX_URI_SIZE)
+    {
+        return parse_error(parser, 414);
+    }
+
+    // "/search?q=c" -> path "/search", query "q=c"
+    const char *question = memchr(target, '?', target_end - target);
+    const char *path_end = question ? question : target_end;
+    request->path = (HttpStr){target, path_end - target};
+    request->query = question ? (HttpStr){question + 1, target_end - question - 1}
+                              : (HttpStr){NULL, 0};
+
+    // Protocol version decides whether keep-alive is the default
+    const char *version = target_end + 1;
+    if (end - version != 8 || memcmp(version, "HTTP/1.", 7) != 0 ||
+        (version[7] != '0' && version[7] != '1'))
+    {
+        return parse_error(parser, 400);
+    }
+    request->http_minor = version[7] - '0';
+
+    /* ============================================
+       PERSISTENT CONNECTIONS
+       ============================================
+       HTTP/1.1 keeps the TCP connection open after a response
+       unless the client says "Connection: close". HTTP/1.0 closes
+       it unless the client asks for "Connection: keep-alive".
+       ============================================ */
+    request->keep_alive = request->http_minor >= 1;
+
+    printf("[PARSE] Method: %.*s, Path: %.*s\n",
+           (int)request->method_name.len, request->method_name.ptr,
+           (int)request->path.len, request->path.ptr);
+    return HTTP_PARSE_NEED_MORE;
+}
+
+/* ============================================
+   PARSE ONE HEADER LINE
+   ============================================
+   Headers are key-value pairs: "Key: Value\r\n"
+   Whitespace around the value is not part of it.
+
+   Two things are refused outright (RFC 9112), because a proxy in
+   front of us may read them differently and then disagree with us
+   about where the body ends and the next pipelined request starts:
+   - whitespace in the name ("Content-Length : 5" is not some other
+     header to us but the length to someone else)
+   - two Content-Length headers with different values
+   ============================================ */
+static HttpParseStatus parse_header_line(HttpParser *parser, HttpRequest *request,
+                                         const char *line, size_t len, const char *colon)
+{
+    if (!colon || colon == line)
     {
-        path_start++; // Skip space
-        char *path_end = strchr(path_start, ' ');
-        if (path_end)
+        return parse_error(parser, 400);
+    }
+
+    HttpStr name = {line, colon - line};
+    for (size_t i = 0; i < name.len; i++)
+    {
+        if (name.ptr[i] == ' ' || name.ptr[i] == '\t')
         {
-            size_t path_len = path_end - path_start;
-            if (path_len < sizeof(request->path))
+            return parse_error(parser, 400);
+        }
+    }
+    const char *value = colon + 1;
+    const char *value_end = line + len;
+    while (value < value_end && (*value == ' ' || *value == '\t'))
+        value++;
+    while (value_end > value && (value_end[-1] == ' ' || value_end[-1] == '\t'))
+        value_end--;
+    size_t value_len = value_end - value;
+
+    HttpStr value_str = {value, value_len};
+    if (http_request_add_header(request, name, value_str) < 0)
+    {
+        return parse_error(parser, 431);
+    }
+
+    // The few headers that shape how the request itself is read
+    switch (http_request_header_at(request, request->header_count - 1)->id)
+    {
+    case HDR_CONTENT_LENGTH:
+    {
+        // Digits only: "-1", "12abc" or an empty value must not parse as a length
+        if (value_len == 0)
+        {
+            return parse_error(parser, 400);
+        }
+        size_t content_length = 0;
+        for (size_t i = 0; i < value_len; i++)
+        {
+            if (value[i] < '0' || value[i] > '9')
+            {
+                return parse_error(parser, 400);
+            }
+            content_length = content_length * 10 + (value[i] - '0');
+            if (content_length > MAX_BODY_SIZE)
             {
-                strncpy(request->path, path_start, path_len);
-                request->path[path_len] = '\0';
+                return parse_error(parser, 413);
             }
         }
+        if (parser->has_content_length && parser->content_length != content_length)
+        {
+            return parse_error(parser, 400);
+        }
+        parser->content_length = content_length;
+        parser->has_content_length = 1;
+        break;
+    }
+    case HDR_CONNECTION:
+        // A comma-separated token list
+        if (header_has_token(value, value_len, "close"))
+        {
+            request->keep_alive = 0;
+        }
+        else if (header_has_token(value, value_len, "keep-alive"))
+        {
+            request->keep_alive = 1;
+        }
+        break;
+    case HDR_TRANSFER_ENCODING:
+        // Chunked request bodies are not supported
+        return parse_error(parser, 501);
+    default:
+        break;
     }
 
-    printf("[PARSE] Method: %s, Path: %s\n",
-           request->method == HTTP_GET ? "GET" : request->method == HTTP_POST ? "POST"
-                                                                              : "UNKNOWN",
-           request->path);
+    return HTTP_PARSE_NEED_MORE;
+}
 
+// Re-point one view after the request bytes moved from old_base to new_base
+static void rebase_str(HttpStr *str, const char *old_base, const char *new_base)
+{
+    if (str->ptr)
+    {
+        str->ptr = new_base + ((uintptr_t)str->ptr - (uintptr_t)old_base);
+    }
+}
+
+// The receive buffer may be reallocated or compacted between reads, so
+// views taken from the earlier bytes must follow them to their new home.
+static void rebase_request(HttpRequest *request, const char *old_base, const char *new_base)
+{
+    rebase_str(&request->method_name, old_base, new_base);
+    rebase_str(&request->path, old_base, new_base);
+    rebase_str(&request->query, old_base, new_base);
+    rebase_str(&request->body, old_base, new_base);
+    for (size_t i = 0; i < request->header_count; i++)
+    {
+        HttpHeader *header = i < HTTP_INLINE_HEADERS
+                                 ? &request->headers[i]
+                                 : &request->extra_headers[i - HTTP_INLINE_HEADERS];
+        rebase_str(&header->name, old_base, new_base);
+        rebase_str(&header->value, old_base, new_base);
+    }
+}
+
+HttpParseStatus http_parser_execute(HttpParser *parser, HttpRequest *request,
+                                    const char *data, size_t length)
+{
     /* ============================================
-       PARSE HEADERS
+       INCREMENTAL PARSING
        ============================================
-       Headers are key-value pairs: "Key: Value\r\n"
-       ============================================ */
+       TCP is a byte stream: one recv() may return half a request,
+       or a request split across several packets. So instead of
+       parsing in one go, the parser is a small state machine:
+
+           REQUEST_LINE -> HEADERS -> BODY -> DONE
+
+       Each call looks only at bytes it has not seen before
+       (from parser->pos on), completes as many lines as it can,
+       and remembers where it stopped. When bytes run out it
+       reports NEED_MORE, and the next call picks up from there.
 
-    line = next_line;
-    size_t content_length = 0;
+       Nothing is copied: method, path, headers and body are all
+       (pointer, length) views into the caller's buffer.
+       ============================================ */
+    if (parser->base && parser->base != data)
+    {
+        rebase_request(request, parser->base, data);
+    }
+    parser->base = data;
 
-    while (line && *line != '\0')
+    while (parser->state == PARSE_REQUEST_LINE || parser->state == PARSE_HEADERS)
     {
-        next_line = strstr(line, "\r\n");
-        if (next_line)
+        /* Find the end of the line. The same pass finds the first ':'
+           of a header line (or the first ' ' of the request line), so
+           each line is only scanned once. */
+        const char *delim = parser->delim ? data + parser->delim : NULL;
+        const char *newline = http_scan_line(data + parser->pos, data + length,
+                                             parser->state == PARSE_HEADERS ? ':' : ' ', &delim);
+        if (newline == data + length)
         {
-            *next_line = '\0';
-            next_line += 2;
+            parser->delim = delim ? (size_t)(delim - data) : 0;
+            parser->pos = length;
+            if (length > MAX_HEADER_SIZE)
+            {
+                return parse_error(parser, 431);
+            }
+            return HTTP_PARSE_NEED_MORE;
         }
 
-        // Empty line marks end of headers
-        if (*line == '\0')
+        const char *line = data + parser->line_start;
+        size_t line_len = newline - line;
+        if (line_len > 0 && line[line_len - 1] == '\r')
         {
-            line = next_line;
-            break;
+            line_len--; // Lines end in CRLF; tolerate a bare LF
         }
 
-        // Parse Content-Type header
-        if (strncasecmp(line, "Content-Type:", 13) == 0)
+        parser->pos = (newline - data) + 1;
+        parser->line_start = parser->pos;
+        parser->delim = 0;
+        if (parser->pos > MAX_HEADER_SIZE)
         {
-            char *value = line + 13;
-            while (*value == ' ')
-                value++; // Skip spaces
-            strncpy(request->content_type, value, sizeof(request->content_type) - 1);
+            return parse_error(parser, 431);
         }
 
-        // Parse Content-Length header
-        if (strncasecmp(line, "Content-Length:", 15) == 0)
+        HttpParseStatus status;
+        if (parser->state == PARSE_REQUEST_LINE)
         {
-            content_length = atoi(line + 15);
+            if (line_len == 0)
+            {
+                continue; // Stray CRLF between requests may be ignored
+            }
+            status = parse_request_line(parser, request, line, line_len, delim);
+            parser->state = PARSE_HEADERS;
+        }
+        else if (line_len == 0)
+        {
+            // Empty line marks end of headers
+            parser->body_start = parser->pos;
+            parser->state = PARSE_BODY;
+            status = HTTP_PARSE_NEED_MORE;
+        }
+        else
+        {
+            status = parse_header_line(parser, request, line, line_len, delim);
         }
 
-        line = next_line;
+        if (status == HTTP_PARSE_ERROR)
+        {
+            return status;
+        }
     }
 
     /* ============================================
        PARSE BODY
        ============================================
-       For POST requests, body comes after headers
+       The body follows the blank line and is exactly
+       Content-Length bytes long.
        ============================================ */
-
-    if (request->method == HTTP_POST && content_length > 0 && line)
+    if (parser->state == PARSE_BODY)
     {
-        request->body_length = content_length;
-        request->body = malloc(content_length + 1);
-        if (request->body)
+        size_t available = length - parser->body_start;
+        if (available < parser->content_length)
         {
-            // The body is already in our buffer after the headers
-            size_t body_offset = line - request_copy;
-            size_t available = strlen(raw_request) - body_offset;
-            size_t to_copy = (available < content_length) ? available : content_length;
+            parser->pos = length;
+            return HTTP_PARSE_NEED_MORE;
+        }
 
-            memcpy(request->body, raw_request + body_offset, to_copy);
-            request->body[to_copy] = '\0';
+        if (parser->content_length > 0)
+        {
+            request->body = (HttpStr){data + parser->body_start, parser->content_length};
 
-            printf("[PARSE] Body length: %zu bytes\n", request->body_length);
-            printf("[PARSE] Body preview: %.100s%s\n",
-                   request->body,
-                   request->body_length > 100 ? "..." : "");
+            printf("[PARSE] Body length: %zu bytes\n", request->body.len);
+            printf("[PARSE] Body preview: %.*s%s\n",
+                   (int)(request->body.len > 100 ? 100 : request->body.len), request->body.ptr,
+                   request->body.len > 100 ? "..." : "");
         }
+
+        parser->pos = parser->body_start + parser->content_length;
+        parser->state = PARSE_DONE;
     }
 
-    free(request_copy);
+    return HTTP_PARSE_COMPLETE;
+}
+
+HttpParseStatus parse_http_request(const char *raw_request, HttpRequest *request)
+{
+    HttpParser parser;
+    http_parser_init(&parser);
+    return http_parser_execute(&parser, request, raw_request, strlen(raw_request));
 }
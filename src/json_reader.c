@@ -0,0 +1,904 @@
+#include "http_server.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================
+   JSON READER
+   ============================================
+   The handlers used to look each field up on its own: search the
+   body for "name", parse what follows the colon, then start over
+   from the top for "email", and again for "role". That is one pass
+   over the body per field, and the search did not know where it
+   was - a key-like string inside a value matched too:
+
+       {"note": "\"role\": \"admin\"", "role": "user"}
+                  ^ found first
+
+   The reader walks the body once, start to end, as a real parser:
+   it knows whether it is in a key, a value or a nested object, and
+   only top-level keys are matched against the members of a struct
+   declared with JSON_SCHEMA() (see http_server.h):
+
+       #define PERSON_FIELDS(X, S) \
+           X(S, JSON_STRING, name) \
+           X(S, JSON_INT,    age)
+       JSON_SCHEMA(Person, PERSON_FIELDS);
+
+       Person person;
+       json_decode(arena, body, &Person_schema, &person);
+       // person.name, person.age
+
+   Each value goes straight into its member, found through the offset
+   in the schema; the key lengths are in the schema too, so most keys
+   are ruled out without comparing a byte. Values nobody asked for are
+   checked (the body must be valid JSON) but never copied. Requested
+   strings are unescaped into the arena, \uXXXX included.
+
+   Large bodies go through a second parser instead, in two stages
+   (the design of simdjson):
+
+   1. Index. Every 64-byte block is classified with SIMD into bit
+      masks (see http_scan_json_block() in scan.c), and a few integer
+      operations on those masks find which bytes are inside strings
+      and which are structural - { } [ ] : , both quotes of each
+      string and the first byte of each number or literal:
+
+          {"a": [1, "x,y"]}
+          11 11 111 1   111  <- 11 positions in the index; the
+                                ',' inside "x,y" is in a string, not
+
+      UTF-8 and the escapes are validated in the same pass (pure
+      ASCII blocks without backslashes, the common case, are skipped
+      in one test each).
+
+   2. Tape. The index is walked once, jumping from one structural
+      position to the next instead of stepping over every byte, and
+      each value becomes a JsonNode in a flat array in the arena.
+      A node records how many nodes its value spans, so whole nested
+      objects are skipped in one step when looking something up.
+
+   Stage 1 is the part that runs at SIMD speed, but it costs an index
+   entry per structural byte, and stage 2 then visits each of them.
+   json_decode() only needs the top-level members, and with SSE4.2 or
+   AVX2 the two stages together just about keep up with the one-pass
+   reader on large bodies (see bench/json_bench.c); without SIMD they
+   are 3x slower. So it takes this path only from json_index_min_bytes
+   up, and the server turns it off when the CPU has no SIMD classifier.
+   ============================================ */
+
+size_t json_index_min_bytes = 64 * 1024;
+
+typedef struct {
+    const char *p;
+    const char *end;
+    Arena *arena;
+    void *out;      // The struct being filled in
+    int depth;
+} JsonReader;
+
+// A string token as it appears in the body, between the quotes
+typedef struct {
+    const char *raw;
+    size_t length;
+    int escaped;    // Contains backslashes: needs decoding
+} JsonToken;
+
+static int parse_value(JsonReader *r, const JsonSchemaField *field);
+
+static void skip_whitespace(JsonReader *r) {
+    while (r->p < r->end &&
+           (*r->p == ' ' || *r->p == '\n' || *r->p == '\r' || *r->p == '\t')) {
+        r->p++;
+    }
+}
+
+static int expect(JsonReader *r, char c) {
+    skip_whitespace(r);
+    if (r->p == r->end || *r->p != c) return -1;
+    r->p++;
+    return 0;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static int read_hex4(const char *p) {
+    int value = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hex_value(p[i]);
+        if (digit < 0) return -1;
+        value = value * 16 + digit;
+    }
+    return value;
+}
+
+// Find the closing quote of a string that starts at p (just after the
+// opening quote), checking the escapes on the way. The clean stretches
+// are skipped with the SIMD scanner.
+static const char *string_end(const char *p, const char *end, int *escaped) {
+    *escaped = 0;
+    for (;;) {
+        p = http_scan_json(p, end);
+        if (p == end) return NULL;      // Unterminated
+
+        if (*p == '"') return p;
+        if (*p != '\\') return NULL;    // Raw control character
+
+        *escaped = 1;
+        if (end - p < 2) return NULL;
+        if (p[1] == 'u') {
+            if (end - p < 6 || read_hex4(p + 2) < 0) return NULL;
+            p += 6;
+        } else if (p[1] != '\0' && strchr("\"\\/bfnrt", p[1])) {
+            p += 2;
+        } else {
+            return NULL;
+        }
+    }
+}
+
+static int scan_string(JsonReader *r, JsonToken *token) {
+    const char *close = string_end(r->p, r->end, &token->escaped);
+    if (!close) return -1;
+    token->raw = r->p;
+    token->length = (size_t)(close - r->p);
+    r->p = close + 1;
+    return 0;
+}
+
+static size_t put_utf8(char *out, unsigned code) {
+    if (code < 0x80) {
+        out[0] = (char)code;
+        return 1;
+    }
+    if (code < 0x800) {
+        out[0] = (char)(0xc0 | (code >> 6));
+        out[1] = (char)(0x80 | (code & 0x3f));
+        return 2;
+    }
+    if (code < 0x10000) {
+        out[0] = (char)(0xe0 | (code >> 12));
+        out[1] = (char)(0x80 | ((code >> 6) & 0x3f));
+        out[2] = (char)(0x80 | (code & 0x3f));
+        return 3;
+    }
+    out[0] = (char)(0xf0 | (code >> 18));
+    out[1] = (char)(0x80 | ((code >> 12) & 0x3f));
+    out[2] = (char)(0x80 | ((code >> 6) & 0x3f));
+    out[3] = (char)(0x80 | (code & 0x3f));
+    return 4;
+}
+
+// Decode the escape at p (a checked one, starting with '\\') into
+// out, 1 to 4 bytes; returns where the next character starts
+static const char *unescape_one(const char *p, const char *end, char *out, size_t *out_length) {
+    char c = p[1];
+    p += 2;
+    *out_length = 1;
+    switch (c) {
+        case 'b': out[0] = '\b'; break;
+        case 'f': out[0] = '\f'; break;
+        case 'n': out[0] = '\n'; break;
+        case 'r': out[0] = '\r'; break;
+        case 't': out[0] = '\t'; break;
+        case 'u': {
+            unsigned code = (unsigned)read_hex4(p);
+            p += 4;
+            if (code >= 0xd800 && code < 0xdc00 && end - p >= 6 &&
+                p[0] == '\\' && p[1] == 'u') {
+                // High surrogate: the low half follows as a second escape
+                int low = read_hex4(p + 2);
+                if (low >= 0xdc00 && low < 0xe000) {
+                    code = 0x10000 + ((code - 0xd800) << 10) + ((unsigned)low - 0xdc00);
+                    p += 6;
+                }
+            }
+            if (code >= 0xd800 && code < 0xe000) code = 0xfffd;  // Lone surrogate
+            *out_length = put_utf8(out, code);
+            break;
+        }
+        default: out[0] = c; break;  // '"', '\\', '/'
+    }
+    return p;
+}
+
+// Unescape a checked token into out (room for raw length + 1). The
+// result is never longer: "\u00e9" (6 bytes) is 2 bytes of UTF-8, a
+// surrogate pair (12 bytes) is 4.
+static size_t unescape(char *out, const char *raw, size_t raw_length) {
+    size_t n = 0;
+    const char *p = raw;
+    const char *end = raw + raw_length;
+    while (p < end) {
+        if (*p != '\\') {
+            out[n++] = *p++;
+            continue;
+        }
+        size_t length;
+        p = unescape_one(p, end, out + n, &length);
+        n += length;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+// Whether a checked, escaped token decodes to `text`, compared as it
+// is decoded: no buffer, so no limit on the length
+static int escaped_equals(const char *raw, size_t raw_length, const char *text,
+                          size_t text_length) {
+    const char *p = raw;
+    const char *end = raw + raw_length;
+    size_t n = 0;
+    while (p < end) {
+        char decoded[4];
+        size_t length = 1;
+        if (*p != '\\') decoded[0] = *p++;
+        else p = unescape_one(p, end, decoded, &length);
+        if (text_length - n < length || memcmp(text + n, decoded, length) != 0) return 0;
+        n += length;
+    }
+    return n == text_length;
+}
+
+// Unescape into the arena
+static char *decode_string(Arena *arena, const char *raw, size_t raw_length, int escaped,
+                           size_t *length) {
+    if (!escaped) {
+        *length = raw_length;
+        return arena_strndup(arena, raw, raw_length);
+    }
+    char *out = arena_alloc(arena, raw_length + 1);
+    if (!out) return NULL;
+    *length = unescape(out, raw, raw_length);
+    return out;
+}
+
+// Check the number grammar; returns where the number ends (NULL if it
+// is not one) and whether it is a whole number (no fraction/exponent)
+static const char *number_end(const char *p, const char *end, int *whole) {
+    if (p < end && *p == '-') p++;
+
+    const char *digits = p;
+    while (p < end && *p >= '0' && *p <= '9') p++;
+    size_t digit_count = (size_t)(p - digits);
+    if (digit_count == 0 || (digit_count > 1 && *digits == '0')) return NULL;
+
+    *whole = 1;
+    if (p < end && *p == '.') {
+        *whole = 0;
+        p++;
+        const char *fraction = p;
+        while (p < end && *p >= '0' && *p <= '9') p++;
+        if (p == fraction) return NULL;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        *whole = 0;
+        p++;
+        if (p < end && (*p == '+' || *p == '-')) p++;
+        const char *exponent = p;
+        while (p < end && *p >= '0' && *p <= '9') p++;
+        if (p == exponent) return NULL;
+    }
+    return p;
+}
+
+// Value of a checked whole number; -1 if it does not fit in 64 bits
+static int whole_number_value(const char *text, size_t length, long long *result) {
+    int negative = text[0] == '-';
+    const char *d = text + negative;
+    const char *end = text + length;
+
+    // Accumulate as unsigned so the most negative value fits too
+    unsigned long long limit = negative ? 9223372036854775808ULL : 9223372036854775807ULL;
+    unsigned long long value = 0;
+    for (; d < end; d++) {
+        unsigned digit = (unsigned)(*d - '0');
+        if (value > (limit - digit) / 10) return -1;
+        value = value * 10 + digit;
+    }
+    *result = negative ? (long long)(0ULL - value) : (long long)value;
+    return 0;
+}
+
+// Store a checked number in a JSON_INT member (if it is a whole number
+// that fits) or a JSON_DOUBLE one
+static int store_number(Arena *arena, const JsonSchemaField *field, void *out,
+                        const char *text, size_t length, int whole) {
+    char *member = (char *)out + field->offset;
+    if (field->type == JSON_INT && whole) {
+        long long value;
+        if (whole_number_value(text, length, &value) == 0) *(long long *)member = value;
+    } else if (field->type == JSON_DOUBLE) {
+        // strtod() wants it NUL-terminated
+        char buffer[64];
+        char *copy = length < sizeof(buffer) ? buffer : arena_alloc(arena, length + 1);
+        if (!copy) return -1;
+        memcpy(copy, text, length);
+        copy[length] = '\0';
+        *(double *)member = strtod(copy, NULL);
+    }
+    return 0;
+}
+
+static int parse_number(JsonReader *r, const JsonSchemaField *field) {
+    const char *start = r->p;
+    int whole;
+    const char *end = number_end(r->p, r->end, &whole);
+    if (!end) return -1;
+    r->p = end;
+
+    if (!field) return 0;
+    return store_number(r->arena, field, r->out, start, (size_t)(end - start), whole);
+}
+
+static int parse_literal(JsonReader *r, const char *word) {
+    size_t length = strlen(word);
+    if ((size_t)(r->end - r->p) < length || memcmp(r->p, word, length) != 0) return -1;
+    r->p += length;
+    return 0;
+}
+
+// Nested containers are only checked: nothing inside them is a field
+static int parse_container(JsonReader *r, char close) {
+    if (++r->depth > JSON_MAX_DEPTH) return -1;
+
+    skip_whitespace(r);
+    if (r->p < r->end && *r->p == close) {
+        r->p++;
+        r->depth--;
+        return 0;
+    }
+    for (;;) {
+        if (close == '}') {
+            JsonToken key;
+            if (expect(r, '"') < 0 || scan_string(r, &key) < 0 || expect(r, ':') < 0) return -1;
+        }
+        if (parse_value(r, NULL) < 0) return -1;
+
+        skip_whitespace(r);
+        if (r->p == r->end) return -1;
+        char c = *r->p++;
+        if (c == close) break;
+        if (c != ',') return -1;
+    }
+    r->depth--;
+    return 0;
+}
+
+// Parse one value; if `field` wants it (and the type matches), keep it
+static int parse_value(JsonReader *r, const JsonSchemaField *field) {
+    skip_whitespace(r);
+    if (r->p == r->end) return -1;
+
+    switch (*r->p) {
+        case '"': {
+            r->p++;
+            JsonToken token;
+            if (scan_string(r, &token) < 0) return -1;
+            if (field && field->type == JSON_STRING) {
+                size_t length;
+                char *string = decode_string(r->arena, token.raw, token.length, token.escaped,
+                                             &length);
+                if (!string) return -1;
+                *(const char **)((char *)r->out + field->offset) = string;
+            }
+            return 0;
+        }
+        case '{': r->p++; return parse_container(r, '}');
+        case '[': r->p++; return parse_container(r, ']');
+        case 't': return parse_literal(r, "true");
+        case 'f': return parse_literal(r, "false");
+        case 'n': return parse_literal(r, "null");
+        default:  return parse_number(r, field);
+    }
+}
+
+static const JsonSchemaField *find_field(const JsonSchema *schema, const char *key,
+                                         size_t length) {
+    for (size_t i = 0; i < schema->count; i++) {
+        const JsonSchemaField *field = &schema->fields[i];
+        if (field->key_length == length && memcmp(field->key, key, length) == 0) return field;
+    }
+    return NULL;
+}
+
+// A key as it appears in the body, looked up in the schema
+static const JsonSchemaField *find_raw_key(Arena *arena, const JsonSchema *schema,
+                                           const char *raw, size_t raw_length, int escaped) {
+    if (!escaped) return find_field(schema, raw, raw_length);
+
+    size_t length;
+    char *name = decode_string(arena, raw, raw_length, 1, &length);
+    return name ? find_field(schema, name, length) : NULL;
+}
+
+// UTF-8 decoding state carried across blocks: how many continuation
+// bytes are still due and the range the next one must be in (the
+// first may be narrower, which rules out overlong forms and
+// surrogates)
+typedef struct {
+    int need;
+    unsigned char low;
+    unsigned char high;
+} Utf8State;
+
+// One byte of a multi-byte sequence (or ASCII, outside one)
+static int utf8_step(Utf8State *state, unsigned char c) {
+    if (state->need) {
+        if (c < state->low || c > state->high) return -1;
+        state->need--;
+        state->low = 0x80;
+        state->high = 0xbf;
+        return 0;
+    }
+    if (c < 0x80) return 0;
+
+    state->low = 0x80;
+    state->high = 0xbf;
+    if (c >= 0xc2 && c <= 0xdf) {
+        state->need = 1;
+    } else if (c >= 0xe0 && c <= 0xef) {
+        state->need = 2;
+        if (c == 0xe0) state->low = 0xa0;        // Overlong
+        else if (c == 0xed) state->high = 0x9f;  // Surrogates
+    } else if (c >= 0xf0 && c <= 0xf4) {
+        state->need = 3;
+        if (c == 0xf0) state->low = 0x90;        // Overlong
+        else if (c == 0xf4) state->high = 0x8f;  // Above U+10FFFF
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+static int utf8_check(Utf8State *state, const unsigned char *p, size_t length) {
+    size_t i = 0;
+    while (i < length) {
+        // Between sequences, skip ASCII eight bytes at a time
+        if (!state->need && length - i >= 8) {
+            unsigned long long word;
+            memcpy(&word, p + i, sizeof(word));
+            if (!(word & 0x8080808080808080ULL)) {
+                i += 8;
+                continue;
+            }
+        }
+        if (utf8_step(state, p[i++]) < 0) return -1;
+    }
+    return 0;
+}
+
+static int decode_one_pass(Arena *arena, HttpStr json, const JsonSchema *schema, void *out) {
+    // The index checks UTF-8 as it goes; here it is a pass of its own
+    Utf8State utf8 = {0, 0x80, 0xbf};
+    if (utf8_check(&utf8, (const unsigned char *)json.ptr, json.len) < 0 || utf8.need) return -1;
+
+    JsonReader r = {json.ptr, json.ptr + json.len, arena, out, 1};
+    if (expect(&r, '{') < 0) return -1;
+
+    skip_whitespace(&r);
+    if (r.p < r.end && *r.p == '}') {
+        r.p++;
+    } else {
+        for (;;) {
+            JsonToken key;
+            if (expect(&r, '"') < 0 || scan_string(&r, &key) < 0 || expect(&r, ':') < 0) {
+                return -1;
+            }
+            const JsonSchemaField *field = find_raw_key(arena, schema, key.raw, key.length,
+                                                        key.escaped);
+            if (parse_value(&r, field) < 0) return -1;
+
+            skip_whitespace(&r);
+            if (r.p == r.end) return -1;
+            char c = *r.p++;
+            if (c == '}') break;
+            if (c != ',') return -1;
+        }
+    }
+
+    // Nothing but whitespace may follow the object
+    skip_whitespace(&r);
+    return r.p == r.end ? 0 : -1;
+}
+
+/* ============================================
+   Stage 1: structural index
+   ============================================ */
+
+// The characters escaped by a backslash: the byte after each run of
+// an odd number of backslashes (a run of two is one escaped '\').
+// Runs starting on even and on odd bits are handled separately, so
+// that one addition carries each run through to its end. `carry`
+// is 1 when the previous block ended in an odd run.
+static unsigned long long escaped_bytes(unsigned long long backslash, unsigned long long *carry) {
+    const unsigned long long even_bits = 0x5555555555555555ULL;
+    const unsigned long long odd_bits = ~even_bits;
+
+    unsigned long long starts = backslash & ~(backslash << 1);
+    unsigned long long even_start_mask = even_bits ^ *carry;
+    unsigned long long even_starts = starts & even_start_mask;
+    unsigned long long odd_starts = starts & ~even_start_mask;
+
+    unsigned long long even_carries = backslash + even_starts;
+    unsigned long long odd_carries;
+    int ends_odd = __builtin_add_overflow(backslash, odd_starts, &odd_carries);
+    odd_carries |= *carry;
+    *carry = (unsigned long long)ends_odd;
+
+    unsigned long long even_carry_ends = even_carries & ~backslash;
+    unsigned long long odd_carry_ends = odd_carries & ~backslash;
+    return (even_carry_ends & odd_bits) | (odd_carry_ends & even_bits);
+}
+
+// Bit n set if an odd number of bits 0..n are set: with the opening
+// and closing quotes as input, that marks the inside of every string
+static unsigned long long prefix_xor(unsigned long long bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// The same check for one block of the index, visiting only the bytes
+// in `high`: a sequence is a lead byte followed by continuation bytes,
+// all non-ASCII, so any gap in the middle of one is an error
+static int utf8_check_block(Utf8State *state, const unsigned char *block,
+                            unsigned long long high) {
+    int expected = 0;  // Where a pending continuation byte must be
+    while (high) {
+        int i = __builtin_ctzll(high);
+        if (state->need && i != expected) return -1;
+        if (utf8_step(state, block[i]) < 0) return -1;
+        expected = i + 1;
+        high &= high - 1;
+    }
+    // A sequence may run on into the next block, but only from the last byte
+    return state->need && expected != 64 ? -1 : 0;
+}
+
+// Check the byte after each escaping backslash: one of "\/bfnrt, or
+// u and four hex digits. Escapes are rare, so this only visits them.
+static int escapes_valid(const char *data, size_t length, size_t offset,
+                         unsigned long long escaped) {
+    while (escaped) {
+        size_t i = offset + (size_t)__builtin_ctzll(escaped);
+        if (i >= length) return 0;  // The input ended in a backslash
+        char c = data[i];
+        if (c == 'u') {
+            if (length - i < 5 || read_hex4(data + i + 1) < 0) return 0;
+        } else if (c == '\0' || !strchr("\"\\/bfnrt", c)) {
+            return 0;
+        }
+        escaped &= escaped - 1;
+    }
+    return 1;
+}
+
+// Stage 1's output, in the arena
+typedef struct {
+    unsigned *positions;        // Of the structural bytes, in order
+    size_t count;
+    // Closing quotes of the strings that contain a backslash, in order:
+    // stage 2 need not look inside a string to know it must be decoded
+    unsigned *escaped;
+    size_t escaped_count;
+    size_t escaped_capacity;
+} JsonIndex;
+
+// Note the closing quotes, in `closing`, of strings that have a
+// backslash before them (in `backslash`, or in an earlier block if
+// *pending). Only runs for the rare blocks with a backslash.
+static int note_escaped_strings(Arena *arena, JsonIndex *index, size_t offset,
+                                unsigned long long closing, unsigned long long backslash,
+                                int *pending) {
+    while (closing) {
+        // Backslashes are only valid inside strings, so any before this
+        // quote (and after the previous one) are in the string it closes
+        unsigned long long before = (closing & (0ULL - closing)) - 1;
+        if (*pending || (backslash & before)) {
+            if (index->escaped_count == index->escaped_capacity) {
+                size_t capacity = index->escaped_capacity ? index->escaped_capacity * 2 : 16;
+                unsigned *escaped = arena_grow(arena, index->escaped,
+                                               index->escaped_capacity * sizeof(unsigned),
+                                               capacity * sizeof(unsigned));
+                if (!escaped) return -1;
+                index->escaped = escaped;
+                index->escaped_capacity = capacity;
+            }
+            index->escaped[index->escaped_count++] =
+                (unsigned)(offset + (size_t)__builtin_ctzll(closing));
+        }
+        *pending = 0;
+        backslash &= ~before;
+        closing &= closing - 1;
+    }
+    // A backslash after the last closing quote: its string ends later
+    if (backslash) *pending = 1;
+    return 0;
+}
+
+// Classify the whole input into `index`; -1 if it is not valid JSON
+// (or out of memory)
+static int build_index(Arena *arena, const char *data, size_t length, JsonIndex *index) {
+    memset(index, 0, sizeof(*index));
+    // At most one position per byte
+    unsigned *positions = arena_alloc(arena, (length + 1) * sizeof(unsigned));
+    if (!positions) return -1;
+
+    unsigned long long escape_carry = 0;   // Previous block ended in an odd backslash run
+    unsigned long long string_carry = 0;   // All ones while inside a string
+    unsigned long long scalar_carry = 0;   // Previous block ended inside a number/literal
+    unsigned long long errors = 0;
+    int escape_pending = 0;                // The open string has a backslash
+    Utf8State utf8 = {0, 0x80, 0xbf};
+    size_t n = 0;
+
+    for (size_t offset = 0; offset < length; offset += 64) {
+        const unsigned char *block = (const unsigned char *)data + offset;
+        size_t available = length - offset;
+        unsigned char padded[64];
+        if (available < 64) {
+            // Last block: spaces after the end change nothing
+            memset(padded, ' ', sizeof(padded));
+            memcpy(padded, block, available);
+            block = padded;
+        }
+
+        JsonBlockMasks masks;
+        http_scan_json_block(block, &masks);
+
+        unsigned long long escaped = escaped_bytes(masks.backslash, &escape_carry);
+        unsigned long long quotes = masks.quote & ~escaped;
+        if (escaped && !escapes_valid(data, length, offset, escaped)) return -1;
+        // Opening quote and contents: 1, closing quote and outside: 0
+        unsigned long long in_string = prefix_xor(quotes) ^ string_carry;
+        string_carry = (unsigned long long)((long long)in_string >> 63);
+
+        if ((masks.backslash || escape_pending) &&
+            note_escaped_strings(arena, index, offset, quotes & ~in_string, masks.backslash,
+                                 &escape_pending) < 0) {
+            return -1;
+        }
+
+        // Control characters are only allowed as whitespace, outside strings
+        errors |= masks.control & (in_string | ~masks.whitespace);
+
+        // Numbers and literals: runs of anything else outside strings.
+        // Only the first byte of each goes in the index.
+        unsigned long long scalar = ~(masks.op | masks.whitespace | masks.quote | in_string);
+        unsigned long long scalar_starts = scalar & ~((scalar << 1) | scalar_carry);
+        scalar_carry = scalar >> 63;
+
+        // Both quotes of each string: stage 2 then knows where a
+        // string ends without looking at the bytes in between
+        unsigned long long structural = (masks.op & ~in_string) | quotes | scalar_starts;
+
+        if ((masks.high || utf8.need) && utf8_check_block(&utf8, block, masks.high) < 0) {
+            return -1;
+        }
+
+        while (structural) {
+            positions[n++] = (unsigned)(offset + (size_t)__builtin_ctzll(structural));
+            structural &= structural - 1;
+        }
+    }
+
+    if (errors || string_carry || utf8.need) return -1;
+    index->positions = positions;
+    index->count = n;
+    return 0;
+}
+
+/* ============================================
+   Stage 2: tape
+   ============================================ */
+
+typedef struct {
+    const char *data;
+    size_t length;
+    const unsigned *positions;
+    size_t count;
+    size_t next;            // Next index entry
+    const unsigned *escaped;
+    size_t escaped_count;
+    size_t next_escaped;    // Next entry of escaped
+    JsonNode *nodes;
+    size_t node_count;
+    int depth;
+} TapeBuilder;
+
+// Byte at the next index entry, 0 past the end
+static char peek(const TapeBuilder *b) {
+    return b->next < b->count ? b->data[b->positions[b->next]] : '\0';
+}
+
+// A number or literal must end where the next token (or the input) starts
+static int ends_token(const TapeBuilder *b, const char *p) {
+    const char *end = b->data + b->length;
+    return p == end || *p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' ||
+           *p == ',' || *p == ':' || *p == ']' || *p == '}';
+}
+
+static int tape_value(TapeBuilder *b) {
+    if (b->next == b->count) return -1;
+    const char *p = b->data + b->positions[b->next++];
+    const char *end = b->data + b->length;
+
+    size_t index = b->node_count++;
+    JsonNode *node = &b->nodes[index];
+    memset(node, 0, sizeof(*node));
+
+    switch (*p) {
+        case '{':
+        case '[': {
+            if (++b->depth > JSON_MAX_DEPTH) return -1;
+            int object = *p == '{';
+            char close = object ? '}' : ']';
+            node->type = object ? JSON_NODE_OBJECT : JSON_NODE_ARRAY;
+
+            unsigned count = 0;
+            if (peek(b) == close) {
+                b->next++;
+            } else {
+                for (;;) {
+                    if (object) {
+                        if (peek(b) != '"' || tape_value(b) < 0 || peek(b) != ':') return -1;
+                        b->next++;
+                    }
+                    if (tape_value(b) < 0) return -1;
+                    count++;
+
+                    char c = peek(b);
+                    b->next++;
+                    if (c == close) break;
+                    if (c != ',') return -1;
+                }
+            }
+            b->depth--;
+            // The children may have moved node_count on; index it again
+            b->nodes[index].count = count;
+            b->nodes[index].span = (unsigned)(b->node_count - index);
+            return 0;
+        }
+        case '"': {
+            // The closing quote is the next entry; stage 1 has checked
+            // the escapes and control characters in between, and noted
+            // the strings with any
+            if (b->next == b->count) return -1;
+            unsigned close = b->positions[b->next++];
+            node->type = JSON_NODE_STRING;
+            node->text = p + 1;
+            node->length = (unsigned)(b->data + close - (p + 1));
+            if (b->next_escaped < b->escaped_count && b->escaped[b->next_escaped] == close) {
+                node->escaped = 1;
+                b->next_escaped++;
+            }
+            node->span = 1;
+            return 0;
+        }
+        case 't':
+        case 'f':
+        case 'n': {
+            const char *word = *p == 't' ? "true" : *p == 'f' ? "false" : "null";
+            size_t length = *p == 'f' ? 5 : 4;
+            if ((size_t)(end - p) < length || memcmp(p, word, length) != 0 ||
+                !ends_token(b, p + length)) {
+                return -1;
+            }
+            node->type = *p == 't' ? JSON_NODE_TRUE : *p == 'f' ? JSON_NODE_FALSE : JSON_NODE_NULL;
+            node->span = 1;
+            return 0;
+        }
+        default: {
+            int whole;
+            const char *number = number_end(p, end, &whole);
+            if (!number || !ends_token(b, number)) return -1;
+            node->type = JSON_NODE_NUMBER;
+            node->text = p;
+            node->length = (unsigned)(number - p);
+            node->whole = whole;
+            node->span = 1;
+            return 0;
+        }
+    }
+}
+
+int json_parse(Arena *arena, HttpStr json, JsonDocument *doc) {
+    doc->nodes = NULL;
+    doc->count = 0;
+    if (!json.ptr || json.len >= UINT_MAX) return -1;
+
+    JsonIndex index;
+    if (build_index(arena, json.ptr, json.len, &index) < 0 || index.count == 0) return -1;
+
+    // Every node starts at an index entry, so count bounds them
+    TapeBuilder b = {json.ptr, json.len, index.positions, index.count, 0,
+                     index.escaped, index.escaped_count, 0, NULL, 0, 0};
+    b.nodes = arena_alloc(arena, index.count * sizeof(JsonNode));
+    if (!b.nodes) return -1;
+
+    if (tape_value(&b) < 0 || b.next != b.count) return -1;
+    doc->nodes = b.nodes;
+    doc->count = b.node_count;
+    return 0;
+}
+
+const JsonNode *json_object_get(const JsonNode *object, const char *key) {
+    if (object->type != JSON_NODE_OBJECT) return NULL;
+
+    size_t key_length = strlen(key);
+    const JsonNode *member = object + 1;
+    for (unsigned i = 0; i < object->count; i++) {
+        const JsonNode *value = member + 1;
+        if (!member->escaped) {
+            if (member->length == key_length && memcmp(member->text, key, key_length) == 0) {
+                return value;
+            }
+        } else if (escaped_equals(member->text, member->length, key, key_length)) {
+            return value;
+        }
+        member = json_node_next(value);
+    }
+    return NULL;
+}
+
+const JsonNode *json_node_next(const JsonNode *node) {
+    return node + node->span;
+}
+
+char *json_node_string(Arena *arena, const JsonNode *node, size_t *length) {
+    if (node->type != JSON_NODE_STRING) return NULL;
+    return decode_string(arena, node->text, node->length, node->escaped, length);
+}
+
+int json_node_int(const JsonNode *node, long long *value) {
+    if (node->type != JSON_NODE_NUMBER || !node->whole) return -1;
+    return whole_number_value(node->text, node->length, value);
+}
+
+static int decode_indexed(Arena *arena, HttpStr json, const JsonSchema *schema, void *out) {
+    JsonDocument doc;
+    if (json_parse(arena, json, &doc) < 0 || doc.nodes[0].type != JSON_NODE_OBJECT) return -1;
+
+    const JsonNode *member = doc.nodes + 1;
+    for (unsigned i = 0; i < doc.nodes[0].count; i++) {
+        const JsonNode *value = member + 1;
+        const JsonSchemaField *field = find_raw_key(arena, schema, member->text, member->length,
+                                                    member->escaped);
+        if (field && field->type == JSON_STRING && value->type == JSON_NODE_STRING) {
+            size_t length;
+            char *string = json_node_string(arena, value, &length);
+            if (!string) return -1;
+            *(const char **)((char *)out + field->offset) = string;
+        } else if (field && value->type == JSON_NODE_NUMBER &&
+                   store_number(arena, field, out, value->text, value->length, value->whole) < 0) {
+            return -1;
+        }
+        member = json_node_next(value);
+    }
+    return 0;
+}
+
+int json_decode(Arena *arena, HttpStr json, const JsonSchema *schema, void *out) {
+    for (size_t i = 0; i < schema->count; i++) {
+        char *member = (char *)out + schema->fields[i].offset;
+        switch (schema->fields[i].type) {
+            case JSON_STRING: *(const char **)member = NULL; break;
+            case JSON_INT:    *(long long *)member = 0; break;
+            case JSON_DOUBLE: *(double *)member = 0; break;
+        }
+    }
+    if (!json.ptr) return -1;
+
+    if (json.len >= json_index_min_bytes) return decode_indexed(arena, json, schema, out);
+    return decode_one_pass(arena, json, schema, out);
+}
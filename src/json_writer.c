@@ -0,0 +1,558 @@
+#include "http_server.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================
+   JSON WRITER
+   ============================================
+   The API handlers used to build their answers by gluing string
+   fragments together, formatting every number through snprintf()
+   into a stack buffer first, and with the indentation typed into
+   each fragment by hand:
+
+       json_builder_append(jb, "    \"id\": ");
+       snprintf(temp, sizeof(temp), "%d,\n", id);
+       json_builder_append(jb, temp);
+
+   The writer knows where it is in the document instead. It keeps
+   the length (appending never rescans the buffer), grows the buffer
+   by doubling (amortized O(1) per byte), and each emitter writes its
+   own separator:
+
+       {"id":7,"name":"Alice","tags":["a","b"]}
+        ^     ^ jw_key() writes the comma, jw_int() nothing at all
+
+   Compact output is the default for the API: the indentation was
+   about a third of every response. Pretty mode gives the old layout
+   back for people reading it in a terminal.
+
+   Strings are copied in clean runs between the bytes that need an
+   escape, found with the SIMD scanner (http_scan_json() in scan.c).
+
+   Structs declared with JSON_SCHEMA() are written by jw_struct() in
+   one call. Their keys are known at compile time, so each one is
+   kept ready as a fragment with its comma - ,"email": - and goes out
+   in a single copy instead of strlen(), an escape scan and three
+   separate appends.
+
+   Numbers are the common case, so they get their own formatting:
+   - integers two digits at a time from a 200-byte table, half the
+     divisions of the digit-by-digit loop and no format parsing
+   - doubles as the shortest text that reads back as the same value:
+     0.1 prints "0.1", not "0.10000000000000001" (%.17g) nor a
+     rounded "0.10" (%.2f) that has lost the rest. The digits come
+     from Grisu2 in integer arithmetic, several times faster than
+     even a single snprintf("%.17g")
+   ============================================ */
+
+#define JW_FIRST_CAPACITY 256
+
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+void jw_init(JsonWriter *w, Arena *arena, int pretty) {
+    memset(w, 0, sizeof(*w));
+    w->arena = arena;
+    w->pretty = pretty;
+}
+
+// Room for `extra` more bytes (plus the final NUL); NULL once failed
+static char *reserve(JsonWriter *w, size_t extra) {
+    if (w->failed) return NULL;
+    if (w->length + extra + 1 > w->capacity) {
+        size_t capacity = w->capacity ? w->capacity * 2 : JW_FIRST_CAPACITY;
+        while (w->length + extra + 1 > capacity) capacity *= 2;
+        char *buffer = arena_grow(w->arena, w->buffer, w->capacity, capacity);
+        if (!buffer) {
+            w->failed = 1;
+            return NULL;
+        }
+        w->buffer = buffer;
+        w->capacity = capacity;
+    }
+    return w->buffer + w->length;
+}
+
+static void put(JsonWriter *w, const char *data, size_t length) {
+    char *out = reserve(w, length);
+    if (!out) return;
+    memcpy(out, data, length);
+    w->length += length;
+}
+
+// Newline and indentation for the current depth (pretty mode only)
+static void newline(JsonWriter *w) {
+    size_t indent = (size_t)w->depth * 2;
+    char *out = reserve(w, indent + 1);
+    if (!out) return;
+    out[0] = '\n';
+    memset(out + 1, ' ', indent);
+    w->length += indent + 1;
+}
+
+// Whatever goes before a value: nothing after a key, otherwise a
+// comma unless it is the first member
+static void begin_value(JsonWriter *w) {
+    if (w->after_key) {
+        w->after_key = 0;
+        return;
+    }
+    if (w->depth == 0) return;
+
+    unsigned long long bit = 1ULL << (w->depth - 1);
+    if (w->filled & bit) put(w, ",", 1);
+    w->filled |= bit;
+    if (w->pretty) newline(w);
+}
+
+static void open_container(JsonWriter *w, char bracket) {
+    begin_value(w);
+    if (w->depth == JSON_MAX_DEPTH) {
+        w->failed = 1;
+        return;
+    }
+    put(w, &bracket, 1);
+    w->depth++;
+    w->filled &= ~(1ULL << (w->depth - 1));
+}
+
+static void close_container(JsonWriter *w, char bracket) {
+    if (w->depth == 0) {
+        w->failed = 1;
+        return;
+    }
+    int had_members = (w->filled >> (w->depth - 1)) & 1;
+    w->depth--;
+    if (w->pretty && had_members) newline(w);
+    put(w, &bracket, 1);
+}
+
+void jw_object_begin(JsonWriter *w) { open_container(w, '{'); }
+void jw_object_end(JsonWriter *w) { close_container(w, '}'); }
+void jw_array_begin(JsonWriter *w) { open_container(w, '['); }
+void jw_array_end(JsonWriter *w) { close_container(w, ']'); }
+
+// The quoted, escaped string. http_scan_json() skips the clean runs
+// 16 or 32 bytes at a time; each is copied in one go.
+static void put_string(JsonWriter *w, const char *str, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+    const char *p = str;
+    const char *end = str + length;
+    put(w, "\"", 1);
+
+    while (p < end) {
+        const char *special = http_scan_json(p, end);
+        put(w, p, (size_t)(special - p));
+        if (special == end) break;
+
+        unsigned char c = (unsigned char)*special;
+        char escape[6] = {'\\', (char)c};
+        size_t escape_length = 2;
+        switch (c) {
+            case '"': case '\\': break;
+            case '\b': escape[1] = 'b'; break;
+            case '\f': escape[1] = 'f'; break;
+            case '\n': escape[1] = 'n'; break;
+            case '\r': escape[1] = 'r'; break;
+            case '\t': escape[1] = 't'; break;
+            default:
+                // Other control characters have no short form
+                memcpy(escape + 1, "u00", 3);
+                escape[4] = hex[c >> 4];
+                escape[5] = hex[c & 15];
+                escape_length = 6;
+                break;
+        }
+        put(w, escape, escape_length);
+        p = special + 1;
+    }
+    put(w, "\"", 1);
+}
+
+void jw_key(JsonWriter *w, const char *key) {
+    begin_value(w);
+    put_string(w, key, strlen(key));
+    if (w->pretty) put(w, ": ", 2);
+    else put(w, ":", 1);
+    w->after_key = 1;
+}
+
+void jw_string(JsonWriter *w, const char *str) {
+    jw_string_n(w, str, strlen(str));
+}
+
+void jw_string_n(JsonWriter *w, const char *str, size_t length) {
+    begin_value(w);
+    put_string(w, str, length);
+}
+
+void jw_int(JsonWriter *w, long long value) {
+    begin_value(w);
+
+    // Written backwards from the end of a buffer that fits any value
+    char digits[20];
+    char *p = digits + sizeof(digits);
+    unsigned long long n = value < 0 ? 0ULL - (unsigned long long)value
+                                     : (unsigned long long)value;
+    while (n >= 100) {
+        const char *pair = digit_pairs + (n % 100) * 2;
+        n /= 100;
+        p -= 2;
+        p[0] = pair[0];
+        p[1] = pair[1];
+    }
+    if (n >= 10) {
+        p -= 2;
+        p[0] = digit_pairs[n * 2];
+        p[1] = digit_pairs[n * 2 + 1];
+    } else {
+        *--p = (char)('0' + n);
+    }
+    if (value < 0) *--p = '-';
+
+    put(w, p, (size_t)(digits + sizeof(digits) - p));
+}
+
+/* Shortest digits for a double: Grisu2 (Florian Loitsch, "Printing
+   Floating-Point Numbers Quickly and Accurately with Integers", 2010).
+
+   A double is f * 2^e. The numbers that read back as it lie in a small
+   interval around it, halfway to each neighbouring double. Grisu scales
+   the value and both ends of that interval by a cached power of ten,
+   so that all three are 64-bit integers with a binary point at a known
+   position, then emits decimal digits of the upper end until what is
+   left is smaller than the interval: those digits name a number inside
+   it, so they read back exactly. One multiplication per value, integer
+   arithmetic only - no snprintf() and no strtod() to check the result.
+
+   The interval is shrunk by one unit at each end to cover the rounding
+   of the multiplications, so the digits are always correct. Rarely
+   (well under 0.1% of values) that costs a digit: one more than the
+   shortest possible, never a wrong one. */
+
+typedef struct {
+    uint64_t f;     // Significand
+    int e;          // Binary exponent: the value is f * 2^e
+} DiyFp;
+
+#define DOUBLE_SIGNIFICAND_BITS 52
+#define DOUBLE_HIDDEN_BIT (1ULL << DOUBLE_SIGNIFICAND_BITS)
+#define DOUBLE_EXPONENT_BIAS (1023 + DOUBLE_SIGNIFICAND_BITS)
+
+// 10^k rounded to 64 bits, for k = -348, -340, ..., 340 (every eighth
+// power: any scale needed is within a factor of 10^8 of one of them)
+static const DiyFp cached_powers[] = {
+    {0xfa8fd5a0081c0288ULL, -1220}, {0xbaaee17fa23ebf76ULL, -1193}, {0x8b16fb203055ac76ULL, -1166},
+    {0xcf42894a5dce35eaULL, -1140}, {0x9a6bb0aa55653b2dULL, -1113}, {0xe61acf033d1a45dfULL, -1087},
+    {0xab70fe17c79ac6caULL, -1060}, {0xff77b1fcbebcdc4fULL, -1034}, {0xbe5691ef416bd60cULL, -1007},
+    {0x8dd01fad907ffc3cULL, -980}, {0xd3515c2831559a83ULL, -954}, {0x9d71ac8fada6c9b5ULL, -927},
+    {0xea9c227723ee8bcbULL, -901}, {0xaecc49914078536dULL, -874}, {0x823c12795db6ce57ULL, -847},
+    {0xc21094364dfb5637ULL, -821}, {0x9096ea6f3848984fULL, -794}, {0xd77485cb25823ac7ULL, -768},
+    {0xa086cfcd97bf97f4ULL, -741}, {0xef340a98172aace5ULL, -715}, {0xb23867fb2a35b28eULL, -688},
+    {0x84c8d4dfd2c63f3bULL, -661}, {0xc5dd44271ad3cdbaULL, -635}, {0x936b9fcebb25c996ULL, -608},
+    {0xdbac6c247d62a584ULL, -582}, {0xa3ab66580d5fdaf6ULL, -555}, {0xf3e2f893dec3f126ULL, -529},
+    {0xb5b5ada8aaff80b8ULL, -502}, {0x87625f056c7c4a8bULL, -475}, {0xc9bcff6034c13053ULL, -449},
+    {0x964e858c91ba2655ULL, -422}, {0xdff9772470297ebdULL, -396}, {0xa6dfbd9fb8e5b88fULL, -369},
+    {0xf8a95fcf88747d94ULL, -343}, {0xb94470938fa89bcfULL, -316}, {0x8a08f0f8bf0f156bULL, -289},
+    {0xcdb02555653131b6ULL, -263}, {0x993fe2c6d07b7facULL, -236}, {0xe45c10c42a2b3b06ULL, -210},
+    {0xaa242499697392d3ULL, -183}, {0xfd87b5f28300ca0eULL, -157}, {0xbce5086492111aebULL, -130},
+    {0x8cbccc096f5088ccULL, -103}, {0xd1b71758e219652cULL, -77}, {0x9c40000000000000ULL, -50},
+    {0xe8d4a51000000000ULL, -24}, {0xad78ebc5ac620000ULL, 3}, {0x813f3978f8940984ULL, 30},
+    {0xc097ce7bc90715b3ULL, 56}, {0x8f7e32ce7bea5c70ULL, 83}, {0xd5d238a4abe98068ULL, 109},
+    {0x9f4f2726179a2245ULL, 136}, {0xed63a231d4c4fb27ULL, 162}, {0xb0de65388cc8ada8ULL, 189},
+    {0x83c7088e1aab65dbULL, 216}, {0xc45d1df942711d9aULL, 242}, {0x924d692ca61be758ULL, 269},
+    {0xda01ee641a708deaULL, 295}, {0xa26da3999aef774aULL, 322}, {0xf209787bb47d6b85ULL, 348},
+    {0xb454e4a179dd1877ULL, 375}, {0x865b86925b9bc5c2ULL, 402}, {0xc83553c5c8965d3dULL, 428},
+    {0x952ab45cfa97a0b3ULL, 455}, {0xde469fbd99a05fe3ULL, 481}, {0xa59bc234db398c25ULL, 508},
+    {0xf6c69a72a3989f5cULL, 534}, {0xb7dcbf5354e9beceULL, 561}, {0x88fcf317f22241e2ULL, 588},
+    {0xcc20ce9bd35c78a5ULL, 614}, {0x98165af37b2153dfULL, 641}, {0xe2a0b5dc971f303aULL, 667},
+    {0xa8d9d1535ce3b396ULL, 694}, {0xfb9b7cd9a4a7443cULL, 720}, {0xbb764c4ca7a44410ULL, 747},
+    {0x8bab8eefb6409c1aULL, 774}, {0xd01fef10a657842cULL, 800}, {0x9b10a4e5e9913129ULL, 827},
+    {0xe7109bfba19c0c9dULL, 853}, {0xac2820d9623bf429ULL, 880}, {0x80444b5e7aa7cf85ULL, 907},
+    {0xbf21e44003acdd2dULL, 933}, {0x8e679c2f5e44ff8fULL, 960}, {0xd433179d9c8cb841ULL, 986},
+    {0x9e19db92b4e31ba9ULL, 1013}, {0xeb96bf6ebadf77d9ULL, 1039}, {0xaf87023b9bf0ee6bULL, 1066},
+};
+
+static const uint64_t powers_of_ten[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+// High 64 bits of the 128-bit product, rounded
+static DiyFp diy_multiply(DiyFp x, DiyFp y) {
+    const uint64_t mask = 0xFFFFFFFFULL;
+    uint64_t a = x.f >> 32, b = x.f & mask;
+    uint64_t c = y.f >> 32, d = y.f & mask;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t middle = (bd >> 32) + (ad & mask) + (bc & mask) + (1ULL << 31);
+    return (DiyFp){ac + (ad >> 32) + (bc >> 32) + (middle >> 32), x.e + y.e + 64};
+}
+
+// Shift left until the top bit is set
+static DiyFp diy_normalize(DiyFp x) {
+    while (!(x.f & (1ULL << 63))) {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+// A cached power c = 10^-k whose product with 2^e has its exponent in
+// [-60, -32], so the integer part of a scaled value fits in 32 bits
+static DiyFp cached_power(int e, int *k) {
+    double dk = (-61 - e) * 0.30102999566398114 + 347;  // log10(2)
+    int ceil_k = (int)dk;
+    if (dk - ceil_k > 0.0) ceil_k++;
+    int index = (ceil_k >> 3) + 1;
+    *k = -(-348 + index * 8);
+    return cached_powers[index];
+}
+
+// Nudge the last digit down while that stays inside the interval and
+// gets closer to the exact value
+static void grisu_round(char *digits, int length, uint64_t delta, uint64_t rest,
+                        uint64_t ten_kappa, uint64_t distance) {
+    while (rest < distance && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < distance || distance - rest > rest + ten_kappa - distance)) {
+        digits[length - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+// Digits of the scaled upper bound `high`, stopping as soon as the rest
+// is below delta (the scaled interval width). value = digits * 10^k.
+static int grisu_digits(DiyFp w, DiyFp high, uint64_t delta, char *digits, int *k) {
+    DiyFp one = {1ULL << -high.e, high.e};
+    uint64_t distance = high.f - w.f;
+    uint32_t integral = (uint32_t)(high.f >> -one.e);
+    uint64_t fraction = high.f & (one.f - 1);
+
+    int kappa = 10;
+    while (kappa > 1 && integral < powers_of_ten[kappa - 1]) kappa--;
+
+    int length = 0;
+    while (kappa > 0) {
+        uint32_t divisor = (uint32_t)powers_of_ten[kappa - 1];
+        uint32_t digit = integral / divisor;
+        integral %= divisor;
+        if (digit || length) digits[length++] = (char)('0' + digit);
+        kappa--;
+        uint64_t rest = ((uint64_t)integral << -one.e) + fraction;
+        if (rest <= delta) {
+            *k += kappa;
+            grisu_round(digits, length, delta, rest, powers_of_ten[kappa] << -one.e, distance);
+            return length;
+        }
+    }
+
+    for (;;) {
+        fraction *= 10;
+        delta *= 10;
+        char digit = (char)(fraction >> -one.e);
+        if (digit || length) digits[length++] = (char)('0' + digit);
+        fraction &= one.f - 1;
+        kappa--;
+        if (fraction < delta) {
+            *k += kappa;
+            grisu_round(digits, length, delta, fraction, one.f,
+                        -kappa < 20 ? distance * powers_of_ten[-kappa] : 0);
+            return length;
+        }
+    }
+}
+
+// Up to 17 digits of a finite, positive value; value = digits * 10^k
+static int grisu2(double value, char *digits, int *k) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int biased_e = (int)(bits >> DOUBLE_SIGNIFICAND_BITS) & 0x7FF;
+    uint64_t significand = bits & (DOUBLE_HIDDEN_BIT - 1);
+
+    DiyFp v;
+    if (biased_e) v = (DiyFp){significand | DOUBLE_HIDDEN_BIT, biased_e - DOUBLE_EXPONENT_BIAS};
+    else v = (DiyFp){significand, 1 - DOUBLE_EXPONENT_BIAS};  // Subnormal
+
+    // The interval's ends, halfway to the neighbours. Below a power of
+    // two the lower neighbour is twice as close.
+    DiyFp high = {(v.f << 1) + 1, v.e - 1};
+    while (!(high.f & (DOUBLE_HIDDEN_BIT << 1))) {
+        high.f <<= 1;
+        high.e--;
+    }
+    high.f <<= 64 - DOUBLE_SIGNIFICAND_BITS - 2;
+    high.e -= 64 - DOUBLE_SIGNIFICAND_BITS - 2;
+    DiyFp low = v.f == DOUBLE_HIDDEN_BIT ? (DiyFp){(v.f << 2) - 1, v.e - 2}
+                                         : (DiyFp){(v.f << 1) - 1, v.e - 1};
+    low.f <<= low.e - high.e;
+    low.e = high.e;
+
+    DiyFp power = cached_power(high.e, k);
+    DiyFp w = diy_multiply(diy_normalize(v), power);
+    DiyFp scaled_high = diy_multiply(high, power);
+    DiyFp scaled_low = diy_multiply(low, power);
+    scaled_low.f++;     // Stay inside the interval whatever the rounding
+    scaled_high.f--;
+    return grisu_digits(w, scaled_high, scaled_high.f - scaled_low.f, digits, k);
+}
+
+void jw_double(JsonWriter *w, double value) {
+    if (!isfinite(value)) {
+        jw_null(w);  // JSON has no NaN or infinity
+        return;
+    }
+    begin_value(w);
+
+    char text[32];
+    char *p = text;
+    if (signbit(value)) {
+        *p++ = '-';
+        value = -value;
+    }
+    if (value == 0) {
+        *p++ = '0';
+        put(w, text, (size_t)(p - text));
+        return;
+    }
+
+    char digits[18];
+    int k;
+    int length = grisu2(value, digits, &k);
+    int point = length + k;  // Where the decimal point goes: value = 0.<digits> * 10^point
+
+    // Laid out like JavaScript's Number.prototype.toString(): plain up
+    // to 21 integer digits or 6 leading zeros, exponent form beyond
+    if (length <= point && point <= 21) {
+        memcpy(p, digits, (size_t)length);          // 1234e2 -> 123400
+        memset(p + length, '0', (size_t)(point - length));
+        p += point;
+    } else if (0 < point && point <= 21) {
+        memcpy(p, digits, (size_t)point);           // 1234e-2 -> 12.34
+        p[point] = '.';
+        memcpy(p + point + 1, digits + point, (size_t)(length - point));
+        p += length + 1;
+    } else if (-6 < point && point <= 0) {
+        memcpy(p, "0.", 2);                         // 1234e-6 -> 0.001234
+        memset(p + 2, '0', (size_t)-point);
+        memcpy(p + 2 - point, digits, (size_t)length);
+        p += 2 - point + length;
+    } else {
+        *p++ = digits[0];                           // 1234e30 -> 1.234e+33
+        if (length > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, (size_t)(length - 1));
+            p += length - 1;
+        }
+        int exponent = point - 1;
+        *p++ = 'e';
+        *p++ = exponent < 0 ? '-' : '+';
+        if (exponent < 0) exponent = -exponent;
+        if (exponent >= 100) *p++ = (char)('0' + exponent / 100);
+        if (exponent >= 10) *p++ = (char)('0' + exponent / 10 % 10);
+        *p++ = (char)('0' + exponent % 10);
+    }
+    put(w, text, (size_t)(p - text));
+}
+
+void jw_bool(JsonWriter *w, int value) {
+    begin_value(w);
+    if (value) put(w, "true", 4);
+    else put(w, "false", 5);
+}
+
+void jw_null(JsonWriter *w) {
+    begin_value(w);
+    put(w, "null", 4);
+}
+
+void jw_struct(JsonWriter *w, const JsonSchema *schema, const void *value) {
+    open_container(w, '{');
+    for (size_t i = 0; i < schema->count; i++) {
+        const JsonSchemaField *field = &schema->fields[i];
+        if (w->pretty) {
+            jw_key(w, field->key);
+        } else {
+            // The first member goes without the comma
+            size_t skip = i == 0;
+            put(w, field->fragment + skip, field->fragment_length - skip);
+            w->after_key = 1;
+        }
+
+        const char *member = (const char *)value + field->offset;
+        switch (field->type) {
+            case JSON_STRING: {
+                const char *str = *(const char *const *)member;
+                if (str) jw_string(w, str);
+                else jw_null(w);
+                break;
+            }
+            case JSON_INT:    jw_int(w, *(const long long *)member); break;
+            case JSON_DOUBLE: jw_double(w, *(const double *)member); break;
+        }
+    }
+    if (schema->count && w->depth > 0) w->filled |= 1ULL << (w->depth - 1);
+    close_container(w, '}');
+}
+
+char *jw_finish(JsonWriter *w, size_t *length) {
+    char *out = reserve(w, 0);
+    if (!out || w->depth != 0) {
+        *length = 0;
+        return NULL;
+    }
+    *out = '\0';
+    *length = w->length;
+    return w->buffer;
+}
+
+void jw_respond(JsonWriter *w, HttpResponse *response, int status_code) {
+    size_t length;
+    char *body = jw_finish(w, &length);
+    if (!body) {
+        response->status_code = 500;
+        strcpy(response->content_type, "text/plain");
+        static const char message[] = "Out of memory";
+        http_response_set_static(response, message, sizeof(message) - 1);
+        return;
+    }
+
+    response->status_code = status_code;
+    strcpy(response->content_type, "application/json");
+    response->body = body;
+    response->body_mode = BODY_ARENA;
+    response->body_length = length;
+}
+
+int json_wants_pretty(const HttpRequest *request) {
+    // "pretty", "pretty=1" or "pretty=true" anywhere in the query
+    const char *p = request->query.ptr;
+    const char *end = p + request->query.len;
+    while (p < end) {
+        const char *amp = memchr(p, '&', (size_t)(end - p));
+        const char *param_end = amp ? amp : end;
+        size_t length = (size_t)(param_end - p);
+
+        if (length >= 6 && memcmp(p, "pretty", 6) == 0) {
+            if (length == 6) return 1;
+            if (p[6] == '=') {
+                return !(length == 8 && p[7] == '0') &&
+                       !(length == 12 && memcmp(p + 7, "false", 5) == 0);
+            }
+        }
+        p = param_end + 1;
+    }
+    return 0;
+}
@@ -1,23 +1,91 @@
 #include "http_server.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define DEFAULT_PORT 8080
+#define DEFAULT_KEEPALIVE_TIMEOUT 5   // seconds
+#define DEFAULT_MAX_REQUESTS 100      // per connection
+#define DEFAULT_STATIC_ROOT "static"
+#define DEFAULT_STATIC_PREFIX "/static/"
+
+static void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s [port] [--workers N] [--io-uring]\n"
+                    "          [--keepalive-timeout S] [--max-requests N]\n"
+                    "          [--static-root DIR] [--static-prefix PATH]\n", program);
+    fprintf(stderr, "  port          TCP port to listen on (default %d)\n", DEFAULT_PORT);
+    fprintf(stderr, "  --workers N   Event-loop threads, 0 = one per CPU (default 1)\n");
+    fprintf(stderr, "  --io-uring    Use io_uring for socket I/O (falls back to epoll)\n");
+    fprintf(stderr, "  --keepalive-timeout S  Close connections idle for S seconds (default %d)\n",
+            DEFAULT_KEEPALIVE_TIMEOUT);
+    fprintf(stderr, "  --max-requests N       Requests per connection before closing (default %d)\n",
+            DEFAULT_MAX_REQUESTS);
+    fprintf(stderr, "  --static-root DIR      Directory of files to serve (default %s)\n",
+            DEFAULT_STATIC_ROOT);
+    fprintf(stderr, "  --static-prefix PATH   URL path they are served under (default %s)\n",
+            DEFAULT_STATIC_PREFIX);
+}
 
 int main(int argc, char *argv[]) {
-    int port = DEFAULT_PORT;
+    ServerConfig config = {
+        .port = DEFAULT_PORT,
+        .workers = 1,
+        .backend = IO_BACKEND_EPOLL,
+        .keepalive_timeout = DEFAULT_KEEPALIVE_TIMEOUT,
+        .max_requests = DEFAULT_MAX_REQUESTS,
+        .static_root = DEFAULT_STATIC_ROOT,
+        .static_prefix = DEFAULT_STATIC_PREFIX,
+    };
     
     // Parse command line arguments
-    if (argc > 1) {
-        port = atoi(argv[1]);
-        if (port <= 0 || port > 65535) {
-            fprintf(stderr, "Error: Invalid port number. Must be between 1 and 65535.\n");
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--workers") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            config.workers = atoi(argv[++i]);
+            if (config.workers < 0 || config.workers > 1024) {
+                fprintf(stderr, "Error: Invalid worker count. Must be between 0 and 1024.\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--keepalive-timeout") == 0 && i + 1 < argc) {
+            config.keepalive_timeout = atoi(argv[++i]);
+            if (config.keepalive_timeout <= 0) {
+                fprintf(stderr, "Error: Keep-alive timeout must be at least 1 second.\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--max-requests") == 0 && i + 1 < argc) {
+            config.max_requests = atoi(argv[++i]);
+            if (config.max_requests <= 0) {
+                fprintf(stderr, "Error: Max requests must be at least 1.\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--static-root") == 0 && i + 1 < argc) {
+            config.static_root = argv[++i];
+        } else if (strcmp(argv[i], "--static-prefix") == 0 && i + 1 < argc) {
+            config.static_prefix = argv[++i];
+            size_t len = strlen(config.static_prefix);
+            if (len < 2 || config.static_prefix[0] != '/' || config.static_prefix[len - 1] != '/') {
+                fprintf(stderr, "Error: Static prefix must start and end with '/', e.g. /static/.\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--io-uring") == 0) {
+            config.backend = IO_BACKEND_IO_URING;
+        } else if (argv[i][0] == '-') {
+            print_usage(argv[0]);
             return 1;
+        } else {
+            config.port = atoi(argv[i]);
+            if (config.port <= 0 || config.port > 65535) {
+                fprintf(stderr, "Error: Invalid port number. Must be between 1 and 65535.\n");
+                return 1;
+            }
         }
     }
     
     // Start the server
-    int result = start_http_server(port);
+    int result = start_http_server(&config);
     
     return result == 0 ? 0 : 1;
-}
\ No newline at end of file
+}
@@ -4,60 +4,196 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* ============================================
+   PRERENDERED ROUTES
+   ============================================
+   Some pages are the same for every visitor: the home page, the
+   glossary and the how-it-works page don't look at the request at
+   all. They live as plain files in assets/, which the build turns
+   into byte arrays inside the binary (tools/embed_assets.c), each
+   with its length, a content hash for the ETag and a gzipped copy.
+
+   At startup the complete response for each one - status line,
+   headers and body - is serialized into a buffer, once for every
+   variant a client can ask for:
+
+       identity or gzip (Accept-Encoding)
+     x 200, or 304 when If-None-Match has the ETag
+     x Connection: keep-alive or close
+
+   A request then just picks a buffer and queues it: no malloc, no
+   snprintf, no strlen, no copy.
+
+   /info is NOT prerendered: it shows the client's own address.
+   ============================================ */
+
+typedef struct {
+    char *path;          // "/" + asset name without ".html"
+    const EmbeddedAsset *asset;
+    char gzip_etag[32];  // The gzip copy is a different representation
+    PrerenderedResponse variants[2][2];  // [gzip][not modified]
+} PrerenderedRoute;
+
+static PrerenderedRoute *prerendered_routes;
+static size_t prerendered_route_count;
+
+static int prerender(PrerenderedResponse *out, const EmbeddedAsset *asset, int gzip,
+                     int not_modified, const char *etag) {
+    HttpResponse response;
+    memset(&response, 0, sizeof(response));
+    response.body_fd = -1;
+    response.status_code = not_modified ? 304 : 200;
+    snprintf(response.content_type, sizeof(response.content_type), "%s",
+             get_mime_type(asset->name));
+    http_response_add_header(&response, "ETag", etag);
+    if (asset->gzip_data) {
+        http_response_add_header(&response, "Vary", "Accept-Encoding");
+    }
+    if (gzip && !not_modified) {
+        http_response_add_header(&response, "Content-Encoding", "gzip");
+    }
+    if (!not_modified) {
+        http_response_set_static(&response,
+                                 (const char *)(gzip ? asset->gzip_data : asset->data),
+                                 gzip ? asset->gzip_length : asset->length);
+    }
+
+    out->keep_alive = http_serialize_response(&response, 0, &out->keep_alive_length);
+    out->close = http_serialize_response(&response, 1, &out->close_length);
+    return out->keep_alive && out->close ? 0 : -1;
+}
+
+int routes_init(void) {
+    prerendered_routes = calloc(embedded_asset_count ? embedded_asset_count : 1,
+                                sizeof(PrerenderedRoute));
+    if (!prerendered_routes) return -1;
+    prerendered_route_count = embedded_asset_count;
+
+    for (size_t i = 0; i < embedded_asset_count; i++) {
+        PrerenderedRoute *route = &prerendered_routes[i];
+        const EmbeddedAsset *asset = &embedded_assets[i];
+        route->asset = asset;
+
+        // "index.html" -> "/", "glossary.html" -> "/glossary", "app.js" -> "/app.js"
+        size_t name_len = strlen(asset->name);
+        if (name_len > 5 && strcmp(asset->name + name_len - 5, ".html") == 0) name_len -= 5;
+        if (name_len == 5 && strncmp(asset->name, "index", 5) == 0) name_len = 0;
+        route->path = malloc(name_len + 2);
+        if (!route->path) {
+            routes_cleanup();
+            return -1;
+        }
+        route->path[0] = '/';
+        memcpy(route->path + 1, asset->name, name_len);
+        route->path[name_len + 1] = '\0';
+
+        // "\"<hash>\"" -> "\"<hash>-gzip\""
+        snprintf(route->gzip_etag, sizeof(route->gzip_etag), "%.*s-gzip\"",
+                 (int)strlen(asset->etag) - 1, asset->etag);
+
+        for (int gzip = 0; gzip <= (asset->gzip_data != NULL); gzip++) {
+            const char *etag = gzip ? route->gzip_etag : asset->etag;
+            if (prerender(&route->variants[gzip][0], asset, gzip, 0, etag) < 0 ||
+                prerender(&route->variants[gzip][1], asset, gzip, 1, etag) < 0) {
+                routes_cleanup();
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+void routes_cleanup(void) {
+    for (size_t i = 0; i < prerendered_route_count; i++) {
+        PrerenderedRoute *route = &prerendered_routes[i];
+        free(route->path);
+        for (int gzip = 0; gzip < 2; gzip++) {
+            for (int not_modified = 0; not_modified < 2; not_modified++) {
+                free(route->variants[gzip][not_modified].keep_alive);
+                free(route->variants[gzip][not_modified].close);
+            }
+        }
+    }
+    free(prerendered_routes);
+    prerendered_routes = NULL;
+    prerendered_route_count = 0;
+}
+
+// The variant of a prerendered route this client should get
+static const PrerenderedResponse *choose_variant(const PrerenderedRoute *route,
+                                                 const HttpRequest *request) {
+    int gzip = route->asset->gzip_data &&
+               http_accepts_encoding(http_request_header(request, HDR_ACCEPT_ENCODING), "gzip");
+
+    HttpStr if_none_match = http_request_header(request, HDR_IF_NONE_MATCH);
+    int not_modified = if_none_match.len &&
+                       http_etag_matches(if_none_match, gzip ? route->gzip_etag
+                                                             : route->asset->etag);
+    return &route->variants[gzip][not_modified];
+}
+
 void route_request(const HttpRequest *request, HttpResponse *response) {
-    printf("[ROUTE] Routing %s %s\n",
-           request->method == HTTP_GET ? "GET" : "POST",
-           request->path);
+    printf("[ROUTE] Routing %.*s %.*s\n",
+           (int)request->method_name.len, request->method_name.ptr,
+           (int)request->path.len, request->path.ptr);
     
     // GET routes
     if (request->method == HTTP_GET) {
-        if (strcmp(request->path, "/") == 0) {
-            handle_root(request, response);
-        } else if (strcmp(request->path, "/info") == 0) {
+        // Pages from assets/, answered with bytes built at startup
+        for (size_t i = 0; i < prerendered_route_count; i++) {
+            if (http_str_equals(request->path, prerendered_routes[i].path)) {
+                response->prerendered = choose_variant(&prerendered_routes[i], request);
+                return;
+            }
+        }
+
+        if (http_str_equals(request->path, "/info")) {
             handle_info(request, response);
-        } else if (strcmp(request->path, "/glossary") == 0) {
-            handle_glossary(request, response);
-        } else if (strcmp(request->path, "/how-it-works") == 0) {
-            handle_how_it_works(request, response);
-        } else if (strcmp(request->path, "/image") == 0) {
+        } else if (http_str_equals(request->path, "/image")) {
             handle_image(request, response);
         }
         // JSON API GET endpoints
-        else if (strcmp(request->path, "/api/health") == 0) {
+        else if (http_str_equals(request->path, "/api/health")) {
             handle_api_health(request, response);
-        } else if (strcmp(request->path, "/api/users") == 0) {
+        } else if (http_str_equals(request->path, "/api/users")) {
             handle_api_users_get(request, response);
-        } else if (strcmp(request->path, "/api/stats") == 0) {
+        } else if (http_str_equals(request->path, "/api/stats")) {
             handle_api_stats(request, response);
-        } else if (strcmp(request->path, "/api/time") == 0) {
+        } else if (http_str_equals(request->path, "/api/time")) {
             handle_api_time(request, response);
+        } else if (http_str_equals(request->path, "/api/primes")) {
+            handle_api_primes(request, response);
         }
         // External API calls
-        else if (strcmp(request->path, "/api/weather") == 0) {
+        else if (http_str_equals(request->path, "/api/weather")) {
             handle_api_weather(request, response);
-        } else if (strcmp(request->path, "/api/exchange") == 0) {
+        } else if (http_str_equals(request->path, "/api/exchange")) {
             handle_api_exchange_rates(request, response);
-        } else if (strcmp(request->path, "/api/quote") == 0) {
+        } else if (http_str_equals(request->path, "/api/quote")) {
             handle_api_quote(request, response);
-        } else if (strcmp(request->path, "/api/proxy") == 0) {
+        } else if (http_str_equals(request->path, "/api/proxy")) {
             handle_api_proxy(request, response);
+        }
+        // Files below the static root
+        else if (http_str_has_prefix(request->path, server_config.static_prefix)) {
+            handle_static(request, response);
         } else {
             handle_not_found(request, response);
         }
     }
     // POST routes
     else if (request->method == HTTP_POST) {
-        if (strcmp(request->path, "/echo") == 0) {
+        if (http_str_equals(request->path, "/echo")) {
             handle_echo(request, response);
-        } else if (strcmp(request->path, "/data") == 0) {
+        } else if (http_str_equals(request->path, "/data")) {
             handle_post_data(request, response);
         }
         // JSON API POST endpoints
-        else if (strcmp(request->path, "/api/users") == 0) {
+        else if (http_str_equals(request->path, "/api/users")) {
             handle_api_users_post(request, response);
-        } else if (strcmp(request->path, "/api/login") == 0) {
+        } else if (http_str_equals(request->path, "/api/login")) {
             handle_api_login(request, response);
-        } else if (strcmp(request->path, "/api/calculate") == 0) {
+        } else if (http_str_equals(request->path, "/api/calculate")) {
             handle_api_calculate(request, response);
         } else {
             handle_not_found(request, response);
@@ -69,177 +205,22 @@ void route_request(const HttpRequest *request, HttpResponse *response) {
     }
 }
 
-void handle_root(const HttpRequest *request, HttpResponse *response) {
-    (void)request;  // Unused
-    
-    const char *html = 
-        "<!DOCTYPE html>\n"
-        "<html>\n"
-        "<head>\n"
-        "    <title>C Web Server</title>\n"
-        "    <style>\n"
-        "        body {\n"
-        "            font-family: 'Courier New', monospace;\n"
-        "            max-width: 800px;\n"
-        "            margin: 50px auto;\n"
-        "            padding: 20px;\n"
-        "            background: #0a0a0a;\n"
-        "            color: #00ff00;\n"
-        "        }\n"
-        "        h1 { border-bottom: 2px solid #00ff00; padding-bottom: 10px; }\n"
-        "        .endpoint {\n"
-        "            background: #1a1a1a;\n"
-        "            padding: 15px;\n"
-        "            margin: 10px 0;\n"
-        "            border-left: 3px solid #00ff00;\n"
-        "        }\n"
-        "        .method { color: #00aaff; font-weight: bold; }\n"
-        "        a { color: #00ff00; }\n"
-        "        code { background: #1a1a1a; padding: 2px 6px; }\n"
-        "    </style>\n"
-        "</head>\n"
-        "<body>\n"
-        "    <h1>🚀 Low-Level C Web Server</h1>\n"
-        "    <p>A TCP/IP socket-based HTTP server written in C.</p>\n"
-        "    \n"
-        "    <h2>Available Endpoints:</h2>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method'>GET</span> <code>/</code><br>\n"
-        "        This page - server home\n"
-        "    </div>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method'>GET</span> <code>/info</code><br>\n"
-        "        Server information and networking details<br>\n"
-        "        <a href='/info'>Visit /info</a>\n"
-        "    </div>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method'>GET</span> <code>/glossary</code><br>\n"
-        "        Complete C language reference with search<br>\n"
-        "        <a href='/glossary'>Browse glossary</a>\n"
-        "    </div>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method'>GET</span> <code>/how-it-works</code><br>\n"
-        "        Deep dive into request/response cycle<br>\n"
-        "        <a href='/how-it-works'>Learn how servers work</a>\n"
-        "    </div>\n"
-        "    \n"
-        "    <h2 style='color:#00aaff;margin:30px 0 15px;'>🔌 JSON API Endpoints</h2>\n"
-        "    <p style='margin-bottom:15px;'>RESTful API that accepts and returns JSON (like real backend servers!)</p>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method get'>GET</span> <code>/api/health</code><br>\n"
-        "        Health check endpoint<br>\n"
-        "        <code style='font-size:12px;'>curl http://localhost:8080/api/health</code>\n"
-        "    </div>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method get'>GET</span> <code>/api/users</code><br>\n"
-        "        Get list of users<br>\n"
-        "        <code style='font-size:12px;'>curl http://localhost:8080/api/users</code>\n"
-        "    </div>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method post'>POST</span> <code>/api/users</code><br>\n"
-        "        Create new user (JSON body required)<br>\n"
-        "        <code style='font-size:12px;'>curl -X POST http://localhost:8080/api/users -H \"Content-Type: application/json\" -d '{\"name\":\"John\",\"email\":\"john@test.com\"}'</code>\n"
-        "    </div>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method post'>POST</span> <code>/api/login</code><br>\n"
-        "        Login with username and password<br>\n"
-        "        <code style='font-size:12px;'>curl -X POST http://localhost:8080/api/login -H \"Content-Type: application/json\" -d '{\"username\":\"admin\",\"password\":\"password\"}'</code>\n"
-        "    </div>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method post'>POST</span> <code>/api/calculate</code><br>\n"
-        "        Calculator API (add, subtract, multiply, divide)<br>\n"
-        "        <code style='font-size:12px;'>curl -X POST http://localhost:8080/api/calculate -H \"Content-Type: application/json\" -d '{\"a\":10,\"b\":5,\"operation\":\"add\"}'</code>\n"
-        "    </div>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method get'>GET</span> <code>/api/stats</code><br>\n"
-        "        Server statistics<br>\n"
-        "        <code style='font-size:12px;'>curl http://localhost:8080/api/stats</code>\n"
-        "    </div>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method get'>GET</span> <code>/api/time</code><br>\n"
-        "        Current server time<br>\n"
-        "        <code style='font-size:12px;'>curl http://localhost:8080/api/time</code>\n"
-        "    </div>\n"
-        "    \n"
-        "    <h2 style='color:#ffaa00;margin:30px 0 15px;'>🌍 External API Integration</h2>\n"
-        "    <p style='margin-bottom:15px;'>Your server calls external APIs and returns their data!</p>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method get'>GET</span> <code>/api/weather</code><br>\n"
-        "        Get London weather (calls wttr.in API)<br>\n"
-        "        <code style='font-size:12px;'>curl http://localhost:8080/api/weather</code>\n"
-        "    </div>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method get'>GET</span> <code>/api/exchange</code><br>\n"
-        "        Get USD exchange rates (calls exchangerate-api.com)<br>\n"
-        "        <code style='font-size:12px;'>curl http://localhost:8080/api/exchange</code>\n"
-        "    </div>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method get'>GET</span> <code>/api/quote</code><br>\n"
-        "        Get random quote (calls quotable.io API)<br>\n"
-        "        <code style='font-size:12px;'>curl http://localhost:8080/api/quote</code>\n"
-        "    </div>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method get'>GET</span> <code>/api/proxy</code><br>\n"
-        "        Proxy to GitHub API (pass-through example)<br>\n"
-        "        <code style='font-size:12px;'>curl http://localhost:8080/api/proxy</code>\n"
-        "    </div>\n"
-        "    \n"
-        "    <h2 style='color:#00aaff;margin:30px 0 15px;'>📝 Other Endpoints</h2>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method'>GET</span> <code>/image</code><br>\n"
-        "        Serves a sample image (binary data transfer)<br>\n"
-        "        <a href='/image'>View image</a>\n"
-        "    </div>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method'>POST</span> <code>/echo</code><br>\n"
-        "        Echoes back your request body<br>\n"
-        "        Try: <code>curl -X POST -d 'Hello Server!' http://localhost:8080/echo</code>\n"
-        "    </div>\n"
-        "    \n"
-        "    <div class='endpoint'>\n"
-        "        <span class='method'>POST</span> <code>/data</code><br>\n"
-        "        Process JSON or form data<br>\n"
-        "        Try: <code>curl -X POST -H 'Content-Type: application/json' -d '{\"name\":\"test\"}' http://localhost:8080/data</code>\n"
-        "    </div>\n"
-        "    \n"
-        "    <h2>Understanding the Network Stack:</h2>\n"
-        "    <ul>\n"
-        "        <li><strong>Application Layer:</strong> HTTP protocol (this server)</li>\n"
-        "        <li><strong>Transport Layer:</strong> TCP sockets (reliable, ordered delivery)</li>\n"
-        "        <li><strong>Network Layer:</strong> IP routing (how packets find the server)</li>\n"
-        "        <li><strong>Link Layer:</strong> Ethernet/WiFi (actual 1s and 0s)</li>\n"
-        "    </ul>\n"
-        "</body>\n"
-        "</html>";
-    
-    response->status_code = 200;
-    strcpy(response->content_type, "text/html; charset=utf-8");
-    response->body_length = strlen(html);
-    response->body = strdup(html);
+// The arena could not hold the page: answer 500 rather than send 200
+// with no body
+static void respond_out_of_memory(HttpResponse *response) {
+    static const char message[] = "Out of memory";
+    response->status_code = 500;
+    strcpy(response->content_type, "text/plain");
+    http_response_set_static(response, message, sizeof(message) - 1);
 }
 
 void handle_info(const HttpRequest *request, HttpResponse *response) {
-    (void)request;  // Unused
-    
-    char html[4096];
-    snprintf(html, sizeof(html),
+    // Looked up by id - no string compares against the header names
+    HttpStr host = http_request_header(request, HDR_HOST);
+    if (!host.len) host = (HttpStr){"(none)", 6};
+
+    // Formatted straight into the request's arena: no copy, no free()
+    char *html = arena_printf(request->arena, &response->body_length,
         "<!DOCTYPE html>\n"
         "<html>\n"
         "<head>\n"
@@ -282,8 +263,10 @@ void handle_info(const HttpRequest *request, HttpResponse *response) {
         "    <div class='info-box'>\n"
         "        <h2>Request Details:</h2>\n"
         "        <p><span class='label'>Method:</span> %s</p>\n"
-        "        <p><span class='label'>Path:</span> %s</p>\n"
+        "        <p><span class='label'>Path:</span> %.*s</p>\n"
         "        <p><span class='label'>Your IP:</span> %s</p>\n"
+        "        <p><span class='label'>Host header:</span> %.*s</p>\n"
+        "        <p><span class='label'>Headers sent:</span> %zu</p>\n"
         "    </div>\n"
         "    \n"
         "    <div class='info-box'>\n"
@@ -296,19 +279,23 @@ void handle_info(const HttpRequest *request, HttpResponse *response) {
         "</body>\n"
         "</html>",
         request->method == HTTP_GET ? "GET" : "POST",
-        request->path,
-        request->client_ip[0] ? request->client_ip : "unknown"
+        (int)request->path.len, request->path.ptr,
+        request->client_ip[0] ? request->client_ip : "unknown",
+        (int)host.len, host.ptr,
+        request->header_count
     );
+    if (!html) {
+        respond_out_of_memory(response);
+        return;
+    }
     
     response->status_code = 200;
     strcpy(response->content_type, "text/html; charset=utf-8");
-    response->body_length = strlen(html);
-    response->body = strdup(html);
+    response->body = html;
+    response->body_mode = BODY_ARENA;
 }
 
 void handle_image(const HttpRequest *request, HttpResponse *response) {
-    (void)request;  // Unused
-    
     /* ============================================
        SERVING BINARY DATA (IMAGES)
        ============================================
@@ -320,10 +307,14 @@ void handle_image(const HttpRequest *request, HttpResponse *response) {
        (This is the PNG signature)
        
        When sending an image:
-       1. Read the file as binary data (not text)
+       1. Open the file (binary data, not text)
        2. Set Content-Type to image/png (or jpeg, gif, etc.)
        3. Set Content-Length to the file size in bytes
        4. Send the raw bytes through the socket
+
+       We never read the file ourselves: the response just names the
+       open file, and sendfile() has the kernel copy it from the page
+       cache to the socket. A bigger image costs no extra memory.
        
        The browser receives these bytes and knows (from Content-Type)
        to interpret them as an image, not text.
@@ -332,19 +323,14 @@ void handle_image(const HttpRequest *request, HttpResponse *response) {
        The difference is how we interpret them!
        ============================================ */
     
-    size_t image_size;
-    unsigned char *image_data = read_image_file("sample.png", &image_size);
-    
-    if (image_data) {
-        response->status_code = 200;
-        strcpy(response->content_type, "image/png");
-        response->body_length = image_size;
-        response->body = (char *)image_data;
-        
-        printf("[IMAGE] Serving image: %zu bytes\n", image_size);
+    CachedFile *image = file_cache_open("sample.png");
+    if (image) {
+        // Also handles Range requests, so a download can resume
+        printf("[IMAGE] Serving image: %zu bytes\n", image->size);
+        http_serve_file(request, response, image);
     } else {
         // If no image file, generate a simple SVG instead
-        const char *svg = 
+        static const char svg[] =
             "<svg width='400' height='300' xmlns='http://www.w3.org/2000/svg'>\n"
             "  <rect width='100%' height='100%' fill='#0a0a0a'/>\n"
             "  <text x='50%' y='50%' text-anchor='middle' fill='#00ff00' font-size='24' font-family='monospace'>\n"
@@ -357,8 +343,7 @@ void handle_image(const HttpRequest *request, HttpResponse *response) {
         
         response->status_code = 200;
         strcpy(response->content_type, "image/svg+xml");
-        response->body_length = strlen(svg);
-        response->body = strdup(svg);
+        http_response_set_static(response, svg, sizeof(svg) - 1);
     }
 }
 
@@ -378,9 +363,14 @@ void handle_echo(const HttpRequest *request, HttpResponse *response) {
        The data arrives as a stream of bytes through the socket.
        ============================================ */
     
-    if (request->body && request->body_length > 0) {
-        char html[8192];
-        snprintf(html, sizeof(html),
+    if (request->body.len > 0) {
+        static const char unspecified[] = "not specified";
+        HttpStr content_type = http_request_header(request, HDR_CONTENT_TYPE);
+        if (!content_type.len) {
+            content_type = (HttpStr){unspecified, sizeof(unspecified) - 1};
+        }
+
+        char *html = arena_printf(request->arena, &response->body_length,
             "<!DOCTYPE html>\n"
             "<html>\n"
             "<head><title>Echo Response</title>\n"
@@ -391,36 +381,65 @@ void handle_echo(const HttpRequest *request, HttpResponse *response) {
             "    <h1>📡 Echo Response</h1>\n"
             "    <div class='box'>\n"
             "        <h3>You sent:</h3>\n"
-            "        <p><strong>Content-Type:</strong> %s</p>\n"
+            "        <p><strong>Content-Type:</strong> %.*s</p>\n"
             "        <p><strong>Content-Length:</strong> %zu bytes</p>\n"
-            "        <pre>%s</pre>\n"
+            "        <pre>%.*s</pre>\n"
             "    </div>\n"
             "    <p>Your data traveled through the network as TCP packets and arrived here!</p>\n"
             "    <p><a href='/'>← Back to home</a></p>\n"
             "</body>\n"
             "</html>",
-            request->content_type[0] ? request->content_type : "not specified",
-            request->body_length,
-            request->body
+            (int)content_type.len, content_type.ptr,
+            request->body.len,
+            (int)request->body.len, request->body.ptr
         );
+        if (!html) {
+            respond_out_of_memory(response);
+            return;
+        }
         
         response->status_code = 200;
         strcpy(response->content_type, "text/html; charset=utf-8");
-        response->body_length = strlen(html);
-        response->body = strdup(html);
+        response->body = html;
+        response->body_mode = BODY_ARENA;
     } else {
-        const char *msg = "No body received in POST request";
+        static const char msg[] = "No body received in POST request";
         response->status_code = 200;
         strcpy(response->content_type, "text/plain");
-        response->body_length = strlen(msg);
-        response->body = strdup(msg);
+        http_response_set_static(response, msg, sizeof(msg) - 1);
     }
 }
 
+// One line about a JSON body: what the top-level value is and how many
+// nodes its tape has (keys and values, nested ones included)
+static const char *describe_json(const HttpRequest *request) {
+    static const char *const type_names[] = {
+        "object", "array", "string", "number", "true", "false", "null"
+    };
+    JsonDocument doc;
+    if (json_parse(request->arena, request->body, &doc) < 0) return "Not valid JSON";
+
+    const JsonNode *top = &doc.nodes[0];
+    size_t length;
+    const char *summary;
+    if (top->type == JSON_NODE_OBJECT || top->type == JSON_NODE_ARRAY) {
+        summary = arena_printf(request->arena, &length, "Valid JSON: %s with %u %s, %zu nodes on the tape",
+                               type_names[top->type], top->count,
+                               top->type == JSON_NODE_OBJECT ? "members" : "elements", doc.count);
+    } else {
+        summary = arena_printf(request->arena, &length, "Valid JSON: %s", type_names[top->type]);
+    }
+    return summary ? summary : "Valid JSON";
+}
+
 void handle_post_data(const HttpRequest *request, HttpResponse *response) {
-    if (request->body && request->body_length > 0) {
-        char html[8192];
-        snprintf(html, sizeof(html),
+    if (request->body.len > 0) {
+        // JSON bodies can be hundreds of KB: they go through the indexed parser
+        HttpStr content_type = http_request_header(request, HDR_CONTENT_TYPE);
+        const char *summary = http_str_has_prefix(content_type, "application/json")
+                              ? describe_json(request) : "Not JSON";
+
+        char *html = arena_printf(request->arena, &response->body_length,
             "<!DOCTYPE html>\n"
             "<html>\n"
             "<head><title>Data Received</title>\n"
@@ -431,26 +450,30 @@ void handle_post_data(const HttpRequest *request, HttpResponse *response) {
             "    <h1>✓ Data Processed</h1>\n"
             "    <div class='box'>\n"
             "        <h3>Received Data:</h3>\n"
-            "        <pre>%s</pre>\n"
+            "        <p>%s</p>\n"
+            "        <pre>%.*s</pre>\n"
             "    </div>\n"
             "    <p><a href='/'>← Back to home</a></p>\n"
             "</body>\n"
             "</html>",
-            request->body
+            summary, (int)request->body.len, request->body.ptr
         );
+        if (!html) {
+            respond_out_of_memory(response);
+            return;
+        }
         
         response->status_code = 200;
         strcpy(response->content_type, "text/html; charset=utf-8");
-        response->body_length = strlen(html);
-        response->body = strdup(html);
+        response->body = html;
+        response->body_mode = BODY_ARENA;
     } else {
         handle_not_found(request, response);
     }
 }
 
 void handle_not_found(const HttpRequest *request, HttpResponse *response) {
-    char html[2048];
-    snprintf(html, sizeof(html),
+    char *html = arena_printf(request->arena, &response->body_length,
         "<!DOCTYPE html>\n"
         "<html>\n"
         "<head><title>404 Not Found</title>\n"
@@ -460,15 +483,19 @@ void handle_not_found(const HttpRequest *request, HttpResponse *response) {
         "<body>\n"
         "    <h1>404</h1>\n"
         "    <h2>Not Found</h2>\n"
-        "    <p>The path <code>%s</code> does not exist on this server.</p>\n"
+        "    <p>The path <code>%.*s</code> does not exist on this server.</p>\n"
         "    <p><a href='/' style='color:#00ff00;'>← Back to home</a></p>\n"
         "</body>\n"
         "</html>",
-        request->path
+        (int)request->path.len, request->path.ptr
     );
+    if (!html) {
+        respond_out_of_memory(response);
+        return;
+    }
     
     response->status_code = 404;
     strcpy(response->content_type, "text/html; charset=utf-8");
-    response->body_length = strlen(html);
-    response->body = strdup(html);
+    response->body = html;
+    response->body_mode = BODY_ARENA;
 }
\ No newline at end of file
@@ -0,0 +1,271 @@
+#include "http_server.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HTTP_SCAN_X86 1
+#endif
+
+/* ============================================
+   SIMD JSON SCANNING
+   ============================================
+   Reading and writing JSON is mostly looking for a handful of
+   bytes: the quotes, backslashes and control characters in a
+   string, and the { } [ ] : , that give a document its shape. A
+   plain loop compares one byte at a time. SIMD ("single
+   instruction, multiple data") registers hold 16 (SSE) or 32 (AVX2)
+   bytes, so one compare checks a whole chunk at once:
+
+       chunk:   H e l l o ,   " w o r l d " \ n
+       == '"' : 0 0 0 0 0 0 0 1 0 0 0 0 0 1 0  0
+                -> first quote at 7, found in one step
+
+   Not every CPU has every instruction set, so the best version is
+   picked once at runtime (cpuid, via __builtin_cpu_supports) and
+   called through a function pointer. The scalar versions are the
+   fallback and the reference the others must agree with.
+
+   HTTP header lines are not scanned here. They are short (~45 bytes),
+   and SSE4.2 and AVX2 versions of the line scanner measured no faster
+   than two memchr() calls, which the C library already vectorizes, so
+   http_scan_line() in http_server.h is just those.
+   ============================================ */
+
+/* JSON strings: the same idea finds the bytes a JSON string cannot
+   hold as they are - '"', '\\' and the control characters below
+   0x20. Everything between two of them is copied with one memcpy(),
+   so a long clean string costs about what copying it does. */
+
+// 1 for the bytes that need escaping inside a JSON string
+static const unsigned char json_escape_table[256] = {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    ['"'] = 1,
+    ['\\'] = 1,
+};
+
+static const char *scan_json_scalar(const char *p, const char *end) {
+    while (p < end && !json_escape_table[(unsigned char)*p]) p++;
+    return p;
+}
+
+/* Whole JSON documents (stage 1 of the structural index, see
+   json_reader.c) need every byte of a 64-byte block sorted into a
+   few classes at once, one bit per byte in each mask. */
+
+enum {
+    JSON_CLASS_BACKSLASH = 1,
+    JSON_CLASS_QUOTE = 2,
+    JSON_CLASS_OP = 4,
+    JSON_CLASS_WHITESPACE = 8,
+    JSON_CLASS_CONTROL = 16,
+};
+
+static const unsigned char json_class_table[256] = {
+    ['\\'] = JSON_CLASS_BACKSLASH,
+    ['"'] = JSON_CLASS_QUOTE,
+    ['{'] = JSON_CLASS_OP, ['}'] = JSON_CLASS_OP,
+    ['['] = JSON_CLASS_OP, [']'] = JSON_CLASS_OP,
+    [':'] = JSON_CLASS_OP, [','] = JSON_CLASS_OP,
+    [' '] = JSON_CLASS_WHITESPACE,
+    ['\t'] = JSON_CLASS_WHITESPACE | JSON_CLASS_CONTROL,
+    ['\n'] = JSON_CLASS_WHITESPACE | JSON_CLASS_CONTROL,
+    ['\r'] = JSON_CLASS_WHITESPACE | JSON_CLASS_CONTROL,
+    [0x00] = JSON_CLASS_CONTROL, [0x01] = JSON_CLASS_CONTROL, [0x02] = JSON_CLASS_CONTROL,
+    [0x03] = JSON_CLASS_CONTROL, [0x04] = JSON_CLASS_CONTROL, [0x05] = JSON_CLASS_CONTROL,
+    [0x06] = JSON_CLASS_CONTROL, [0x07] = JSON_CLASS_CONTROL, [0x08] = JSON_CLASS_CONTROL,
+    [0x0b] = JSON_CLASS_CONTROL, [0x0c] = JSON_CLASS_CONTROL, [0x0e] = JSON_CLASS_CONTROL,
+    [0x0f] = JSON_CLASS_CONTROL, [0x10] = JSON_CLASS_CONTROL, [0x11] = JSON_CLASS_CONTROL,
+    [0x12] = JSON_CLASS_CONTROL, [0x13] = JSON_CLASS_CONTROL, [0x14] = JSON_CLASS_CONTROL,
+    [0x15] = JSON_CLASS_CONTROL, [0x16] = JSON_CLASS_CONTROL, [0x17] = JSON_CLASS_CONTROL,
+    [0x18] = JSON_CLASS_CONTROL, [0x19] = JSON_CLASS_CONTROL, [0x1a] = JSON_CLASS_CONTROL,
+    [0x1b] = JSON_CLASS_CONTROL, [0x1c] = JSON_CLASS_CONTROL, [0x1d] = JSON_CLASS_CONTROL,
+    [0x1e] = JSON_CLASS_CONTROL, [0x1f] = JSON_CLASS_CONTROL,
+};
+
+static void classify_json_scalar(const unsigned char *block, JsonBlockMasks *masks) {
+    memset(masks, 0, sizeof(*masks));
+    for (int i = 0; i < 64; i++) {
+        unsigned char c = block[i];
+        unsigned char cls = json_class_table[c];
+        unsigned long long bit = 1ULL << i;
+        if (cls & JSON_CLASS_BACKSLASH) masks->backslash |= bit;
+        if (cls & JSON_CLASS_QUOTE) masks->quote |= bit;
+        if (cls & JSON_CLASS_OP) masks->op |= bit;
+        if (cls & JSON_CLASS_WHITESPACE) masks->whitespace |= bit;
+        if (cls & JSON_CLASS_CONTROL) masks->control |= bit;
+        if (c & 0x80) masks->high |= bit;
+    }
+}
+
+#ifdef HTTP_SCAN_X86
+
+// Three compares per 16 bytes, then one mask for all of them. (PCMPESTRI
+// in ranges mode finds the same set in one instruction, but that is a
+// microcoded multi-cycle op.) There is no unsigned byte compare in SSE:
+// c <= 0x1f is max(c, 0x1f) == 0x1f.
+__attribute__((target("sse4.2")))
+static const char *scan_json_sse42(const char *p, const char *end) {
+    const __m128i control_max = _mm_set1_epi8(0x1f);
+    const __m128i quotes = _mm_set1_epi8('"');
+    const __m128i backslashes = _mm_set1_epi8('\\');
+
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+        __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(chunk, control_max), control_max);
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quotes),
+                                       _mm_cmpeq_epi8(chunk, backslashes));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(control, special));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return scan_json_scalar(p, end);
+}
+
+/* The SIMD classifiers look both sets up by the low four bits of each
+   byte (PSHUFB), then compare: a byte is whitespace if the table entry
+   for its low nibble is the byte itself. Entries that cannot match
+   are values whose own low nibble differs from their index.
+
+       ' ' = 0x20 -> entry 0    '\t' = 0x09 -> entry 9
+       '\n' = 0x0a -> entry 10  '\r' = 0x0d -> entry 13
+
+   The ops use the same trick after OR-ing in 0x20, which turns '['
+   and ']' into '{' and '}'. That also maps a few control characters
+   onto ops (0x0c -> ','), so those are taken out again. */
+
+#define JSON_WHITESPACE_TABLE ' ', 100, 100, 100, 17, 100, 113, 2, \
+                              100, '\t', '\n', 112, 100, '\r', 100, 100
+#define JSON_OP_TABLE 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0
+
+__attribute__((target("sse4.2")))
+static void classify_json_sse42(const unsigned char *block, JsonBlockMasks *masks) {
+    const __m128i whitespace_table = _mm_setr_epi8(JSON_WHITESPACE_TABLE);
+    const __m128i op_table = _mm_setr_epi8(JSON_OP_TABLE);
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i control_max = _mm_set1_epi8(0x1f);
+    const __m128i quotes = _mm_set1_epi8('"');
+    const __m128i backslashes = _mm_set1_epi8('\\');
+
+    memset(masks, 0, sizeof(*masks));
+    for (int i = 0; i < 4; i++) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(block + i * 16));
+        __m128i whitespace = _mm_cmpeq_epi8(_mm_shuffle_epi8(whitespace_table, chunk), chunk);
+        __m128i op = _mm_cmpeq_epi8(_mm_shuffle_epi8(op_table, chunk), _mm_or_si128(chunk, lower));
+        __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(chunk, control_max), control_max);
+        int shift = i * 16;
+
+        masks->backslash |= (unsigned long long)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslashes)) << shift;
+        masks->quote |= (unsigned long long)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quotes)) << shift;
+        masks->op |= (unsigned long long)(unsigned)_mm_movemask_epi8(_mm_andnot_si128(control, op)) << shift;
+        masks->whitespace |= (unsigned long long)(unsigned)_mm_movemask_epi8(whitespace) << shift;
+        masks->control |= (unsigned long long)(unsigned)_mm_movemask_epi8(control) << shift;
+        masks->high |= (unsigned long long)(unsigned)_mm_movemask_epi8(chunk) << shift;
+    }
+}
+
+// No unsigned byte compare in AVX2: c <= 0x1f is max(c, 0x1f) == 0x1f
+__attribute__((target("avx2")))
+static const char *scan_json_avx2(const char *p, const char *end) {
+    const __m256i control_max = _mm256_set1_epi8(0x1f);
+    const __m256i quotes = _mm256_set1_epi8('"');
+    const __m256i backslashes = _mm256_set1_epi8('\\');
+
+    while (end - p >= 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)p);
+        __m256i control = _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control_max), control_max);
+        __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quotes),
+                                          _mm256_cmpeq_epi8(chunk, backslashes));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(control, special));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return scan_json_scalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static void classify_json_avx2(const unsigned char *block, JsonBlockMasks *masks) {
+    const __m256i whitespace_table = _mm256_setr_epi8(JSON_WHITESPACE_TABLE, JSON_WHITESPACE_TABLE);
+    const __m256i op_table = _mm256_setr_epi8(JSON_OP_TABLE, JSON_OP_TABLE);
+    const __m256i lower = _mm256_set1_epi8(0x20);
+    const __m256i control_max = _mm256_set1_epi8(0x1f);
+    const __m256i quotes = _mm256_set1_epi8('"');
+    const __m256i backslashes = _mm256_set1_epi8('\\');
+
+    memset(masks, 0, sizeof(*masks));
+    for (int i = 0; i < 2; i++) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(block + i * 32));
+        __m256i whitespace = _mm256_cmpeq_epi8(_mm256_shuffle_epi8(whitespace_table, chunk), chunk);
+        __m256i op = _mm256_cmpeq_epi8(_mm256_shuffle_epi8(op_table, chunk),
+                                       _mm256_or_si256(chunk, lower));
+        __m256i control = _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control_max), control_max);
+        int shift = i * 32;
+
+        masks->backslash |= (unsigned long long)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, backslashes)) << shift;
+        masks->quote |= (unsigned long long)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quotes)) << shift;
+        masks->op |= (unsigned long long)(unsigned)_mm256_movemask_epi8(_mm256_andnot_si256(control, op)) << shift;
+        masks->whitespace |= (unsigned long long)(unsigned)_mm256_movemask_epi8(whitespace) << shift;
+        masks->control |= (unsigned long long)(unsigned)_mm256_movemask_epi8(control) << shift;
+        masks->high |= (unsigned long long)(unsigned)_mm256_movemask_epi8(chunk) << shift;
+    }
+}
+
+#endif
+
+static const char *const scan_names[] = {
+    [HTTP_SCAN_SCALAR] = "scalar",
+    [HTTP_SCAN_SSE42] = "sse4.2",
+    [HTTP_SCAN_AVX2] = "avx2",
+};
+
+static const char *scan_json_resolve(const char *p, const char *end);
+static void classify_json_resolve(const unsigned char *block, JsonBlockMasks *masks);
+
+// Start out pointing at resolvers, which swap in the real ones on
+// first use. start_http_server() selects before any worker starts, so
+// the workers only ever read them.
+HttpScanJsonFn http_scan_json = scan_json_resolve;
+HttpScanJsonBlockFn http_scan_json_block = classify_json_resolve;
+
+HttpScanImpl http_scan_best(void) {
+#ifdef HTTP_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return HTTP_SCAN_AVX2;
+    if (__builtin_cpu_supports("sse4.2")) return HTTP_SCAN_SSE42;
+#endif
+    return HTTP_SCAN_SCALAR;
+}
+
+HttpScanImpl http_scan_select(HttpScanImpl impl) {
+    HttpScanImpl best = http_scan_best();
+    if (impl > best) impl = best;
+
+    HttpScanJsonFn json_fn = scan_json_scalar;
+    HttpScanJsonBlockFn block_fn = classify_json_scalar;
+#ifdef HTTP_SCAN_X86
+    if (impl == HTTP_SCAN_AVX2) {
+        json_fn = scan_json_avx2;
+        block_fn = classify_json_avx2;
+    } else if (impl == HTTP_SCAN_SSE42) {
+        json_fn = scan_json_sse42;
+        block_fn = classify_json_sse42;
+    }
+#endif
+    http_scan_json = json_fn;
+    http_scan_json_block = block_fn;
+    return impl;
+}
+
+static const char *scan_json_resolve(const char *p, const char *end) {
+    http_scan_select(HTTP_SCAN_AVX2);
+    return http_scan_json(p, end);
+}
+
+static void classify_json_resolve(const unsigned char *block, JsonBlockMasks *masks) {
+    http_scan_select(HTTP_SCAN_AVX2);
+    http_scan_json_block(block, masks);
+}
+
+const char *http_scan_name(HttpScanImpl impl) {
+    return scan_names[impl];
+}
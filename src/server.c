@@ -1,41 +1,221 @@
+#define _GNU_SOURCE  // accept4()
 #include "http_server.h"
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <stdint.h>
+#include <pthread.h>
 #include <sys/socket.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <signal.h>
 #include <errno.h>
 
-volatile sig_atomic_t server_running = 1;
+#define MAX_EVENTS 256
 
-void handle_signal(int sig) {
+ServerConfig server_config;
+
+// eventfd the signal handler pokes to wake every event loop for shutdown.
+// It is never drained, so it stays readable and each worker sees it.
+static int shutdown_fd = -1;
+
+// One event-loop thread with its own listening socket and clients
+typedef struct {
+    int id;
+    IoBackend backend;
+    int server_fd;
+    int epoll_fd;
+    ConnectionList connections;  // Every live connection, least recently active first
+    pthread_t thread;
+} Worker;
+
+// Markers stored in epoll_event.data.ptr for the two non-client fds
+static char listener_tag;
+static char shutdown_tag;
+
+static void handle_signal(int sig) {
     if (sig == SIGINT || sig == SIGTERM) {
-        printf("\n[SERVER] Shutting down gracefully...\n");
-        server_running = 0;
+        // write() is async-signal-safe; printf() is not
+        int saved_errno = errno;
+        uint64_t one = 1;
+        ssize_t ignored = write(shutdown_fd, &one, sizeof(one));
+        (void)ignored;
+        errno = saved_errno;
     }
 }
 
-int start_http_server(int port) {
+/* ============================================
+   CONNECTION BOOKKEEPING
+   ============================================ */
+
+static void close_connection(Worker *worker, Connection *conn) {
+    connection_list_remove(&worker->connections, conn);
+    connection_destroy(conn);
+    printf("[CONNECTION] Connection closed\n\n");
+}
+
+/* ============================================
+   ACCEPT ALL PENDING CONNECTIONS
+   ============================================
+   accept() completes the TCP 3-way handshake and creates a NEW
+   socket for this specific client:
+   - server_fd stays listening for new connections
+   - client_fd is for communicating with THIS client
+
+   The listener is edge-triggered, so one wakeup may stand for many
+   queued clients: keep accepting until the kernel says EAGAIN.
+   accept4() hands back sockets that are already non-blocking.
+   ============================================ */
+static void accept_connections(Worker *worker) {
+    for (;;) {
+        struct sockaddr_in client_addr;
+        socklen_t client_addr_len = sizeof(client_addr);
+
+        int client_fd = accept4(worker->server_fd, (struct sockaddr *)&client_addr,
+                                &client_addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("[ERROR] Accept failed");
+            }
+            return;
+        }
+
+        // Convert client IP address to human-readable format
+        char client_ip[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, INET_ADDRSTRLEN);
+
+        printf("[CONNECTION] Worker %d: new connection from %s:%d\n",
+               worker->id, client_ip, ntohs(client_addr.sin_port));
+
+        Connection *conn = connection_create(client_fd, client_ip);
+        if (!conn) {
+            fprintf(stderr, "[ERROR] Out of memory for connection\n");
+            close(client_fd);
+            continue;
+        }
+
+        /* EPOLLOUT is registered up front: with EPOLLET it only fires
+           when the send buffer goes from full to writable, so there is
+           no need to toggle it with epoll_ctl() on every response. */
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = conn;
+        if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, client_fd, &ev) < 0) {
+            perror("[ERROR] epoll_ctl failed");
+            connection_destroy(conn);
+            continue;
+        }
+
+        connection_list_add(&worker->connections, conn);
+    }
+}
+
+/* ============================================
+   SERVICE ONE READY CLIENT
+   ============================================ */
+static void handle_client_event(Worker *worker, Connection *conn, uint32_t events) {
+    if (events & EPOLLERR) {
+        close_connection(worker, conn);
+        return;
+    }
+
+    connection_list_touch(&worker->connections, conn);
+
+    int peer_open = 1;
+    int want_read = (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) != 0;
+    do {
+        if (want_read) {
+            printf("[REQUEST] Reading data from socket...\n");
+            int status = connection_read(conn);
+            if (status < 0) {
+                close_connection(worker, conn);
+                return;
+            }
+            peer_open = status;
+        }
+
+        /* With keep-alive, one read may already hold the next request,
+           and a drained write queue frees us to answer it. Keep going
+           until we either run out of complete requests or the socket
+           stops accepting output. */
+        for (;;) {
+            // Parse, route and queue a response if a full request arrived
+            handle_client_connection(conn);
+
+            if (!connection_has_pending_output(conn)) {
+                break;
+            }
+
+            int status = connection_flush(conn);
+            if (status < 0) {
+                close_connection(worker, conn);
+                return;
+            }
+            if (status == 0) {
+                return;  // Resume on the next EPOLLOUT
+            }
+            if (connection_finished(conn)) {
+                break;
+            }
+        }
+
+        /* If the read stopped because the buffer was full, the kernel
+           may still hold bytes. Edge-triggered epoll will not report
+           them again, so read once more now that requests have been
+           consumed. */
+        want_read = conn->read_full;
+    } while (want_read && !conn->close_after_write && peer_open);
+
+    if (conn->close_after_write || !peer_open) {
+        close_connection(worker, conn);
+    }
+}
+
+/* ============================================
+   CLOSE IDLE CONNECTIONS
+   ============================================
+   A keep-alive client may go quiet and never come back. The list
+   is ordered by last activity, so expired connections are all at
+   the head. Returns how long epoll_wait() may sleep until the next
+   one expires (-1 = no connections, sleep until an event).
+   ============================================ */
+static int expire_idle_connections(Worker *worker) {
+    long long timeout_ms = (long long)server_config.keepalive_timeout * 1000;
+    long long now = connection_now_ms();
+
+    while (worker->connections.head) {
+        Connection *oldest = worker->connections.head;
+        long long idle = now - oldest->last_active_ms;
+        if (idle < timeout_ms) {
+            // A timeout of weeks does not fit epoll_wait()'s int
+            long long wait_ms = timeout_ms - idle;
+            return wait_ms > INT_MAX ? INT_MAX : (int)wait_ms;
+        }
+
+        printf("[CONNECTION] Closing idle connection from %s\n", oldest->client_ip);
+        close_connection(worker, oldest);
+    }
+
+    return -1;
+}
+
+/* ============================================
+   CREATE ONE LISTENING SOCKET
+   ============================================
+   Every worker calls this for itself. With SO_REUSEPORT, several
+   sockets may bind the very same port; the kernel then hashes each
+   incoming connection onto one of them. There is no shared accept
+   queue and no lock between workers, so adding cores adds capacity.
+   ============================================ */
+static int create_listener(int port, int verbose) {
     int server_fd;
     struct sockaddr_in server_addr;
-    
-    printf("\n========================================\n");
-    printf("HTTP SERVER - Low Level Implementation\n");
-    printf("========================================\n\n");
-    
-    // Set up signal handler for graceful shutdown
-    signal(SIGINT, handle_signal);
-    signal(SIGTERM, handle_signal);
-    
-    // Ignore SIGPIPE - handle broken pipe errors gracefully
-    // SIGPIPE is sent when writing to a closed socket
-    // Without this, the server crashes when a client disconnects early
-    signal(SIGPIPE, SIG_IGN);
-    
+
     /* ============================================
        STEP 1: CREATE A SOCKET
        ============================================
@@ -47,14 +227,17 @@ int start_http_server(int port) {
        
        This returns a file descriptor - in Unix, everything is a file!
        You can read/write to this socket like a file.
+
+       SOCK_NONBLOCK makes accept() return EAGAIN instead of waiting
+       when no client is queued, which the event loop relies on.
        ============================================ */
-    printf("[SOCKET] Creating socket endpoint...\n");
-    server_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (verbose) printf("[SOCKET] Creating socket endpoint...\n");
+    server_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (server_fd < 0) {
         perror("[ERROR] Socket creation failed");
         return -1;
     }
-    printf("[SOCKET] Socket created successfully (fd: %d)\n", server_fd);
+    if (verbose) printf("[SOCKET] Socket created successfully (fd: %d)\n", server_fd);
     
     /* ============================================
        STEP 2: SET SOCKET OPTIONS
@@ -62,14 +245,18 @@ int start_http_server(int port) {
        SO_REUSEADDR allows reusing the address immediately
        Without this, you'd have to wait ~60 seconds after stopping
        the server before you could start it again on the same port
+
+       SO_REUSEPORT lets each worker bind its own socket to the
+       same port (see above)
        ============================================ */
     int opt = 1;
-    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0 ||
+        setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
         perror("[ERROR] Setsockopt failed");
         close(server_fd);
         return -1;
     }
-    printf("[SOCKET] Socket options configured\n");
+    if (verbose) printf("[SOCKET] Socket options configured\n");
     
     /* ============================================
        STEP 3: BIND SOCKET TO ADDRESS
@@ -91,133 +278,265 @@ int start_http_server(int port) {
     server_addr.sin_addr.s_addr = INADDR_ANY;  // Listen on all network interfaces
     server_addr.sin_port = htons(port);         // Convert port to network byte order
     
-    printf("[BIND] Binding socket to 0.0.0.0:%d...\n", port);
+    if (verbose) printf("[BIND] Binding socket to 0.0.0.0:%d...\n", port);
     if (bind(server_fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
         perror("[ERROR] Bind failed");
         close(server_fd);
         return -1;
     }
-    printf("[BIND] Socket bound successfully\n");
+    if (verbose) printf("[BIND] Socket bound successfully\n");
     
     /* ============================================
        STEP 4: LISTEN FOR CONNECTIONS
        ============================================
        listen() marks the socket as passive - it will accept incoming connections
        
-       The backlog parameter (10) is the maximum length of the queue
-       of pending connections. When a client tries to connect:
+       The backlog parameter (SOMAXCONN) is the maximum length of the
+       queue of pending connections. When a client tries to connect:
        1. TCP handshake begins (SYN, SYN-ACK, ACK)
        2. Connection is queued
        3. Your accept() call retrieves it from the queue
        ============================================ */
-    printf("[LISTEN] Starting to listen for connections (backlog: 10)...\n");
-    if (listen(server_fd, 10) < 0) {
+    if (verbose) printf("[LISTEN] Starting to listen for connections (backlog: %d)...\n", SOMAXCONN);
+    if (listen(server_fd, SOMAXCONN) < 0) {
         perror("[ERROR] Listen failed");
         close(server_fd);
         return -1;
     }
+
+    return server_fd;
+}
+
+/* ============================================
+   ONE WORKER'S EVENT LOOP
+   ============================================ */
+static void *worker_main(void *arg) {
+    Worker *worker = arg;
+
+    if (worker->backend == IO_BACKEND_IO_URING) {
+        if (run_io_uring_loop(worker->id, worker->server_fd, shutdown_fd) == 0) {
+            file_cache_trim();
+            compress_cache_trim();
+            buffer_pool_trim();
+            return NULL;
+        }
+        // Older kernel: keep serving with plain syscalls instead
+        fprintf(stderr, "[URING] Worker %d: falling back to epoll\n", worker->id);
+    }
+
+    /* ============================================
+       STEP 5: CREATE THE EVENT LOOP
+       ============================================
+       epoll lets one thread watch thousands of sockets at once.
+       We register:
+       - server_fd:   readable when clients are waiting in accept()
+       - shutdown_fd: readable when SIGINT/SIGTERM arrived
+       - every client_fd: readable/writable as data moves
+
+       epoll_wait() then sleeps until at least one of them is ready
+       and tells us exactly which, so no client ever waits behind
+       another client's slow upload or download.
+       ============================================ */
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.ptr = &listener_tag;
+    epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, worker->server_fd, &ev);
+
+    // Level-triggered, so every worker keeps seeing it until exit
+    ev.events = EPOLLIN;
+    ev.data.ptr = &shutdown_tag;
+    epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, shutdown_fd, &ev);
+
+    /* ============================================
+       MAIN SERVER LOOP
+       ============================================
+       STEP 6: wait for readiness, accept new clients,
+       and read/parse/route/respond for ready ones.
+       ============================================ */
+    struct epoll_event events[MAX_EVENTS];
+    int running = 1;
+
+    while (running) {
+        int wait_ms = expire_idle_connections(worker);
+        int ready = epoll_wait(worker->epoll_fd, events, MAX_EVENTS, wait_ms);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            perror("[ERROR] epoll_wait failed");
+            break;
+        }
+
+        for (int i = 0; i < ready; i++) {
+            void *tag = events[i].data.ptr;
+
+            if (tag == &shutdown_tag) {
+                running = 0;
+            } else if (tag == &listener_tag) {
+                accept_connections(worker);
+            } else {
+                handle_client_event(worker, tag, events[i].events);
+            }
+        }
+    }
+
+    /* ============================================
+       STEP 7: CLEAN UP
+       ============================================
+       Close every client still connected to this worker
+       ============================================ */
+    while (worker->connections.head) {
+        close_connection(worker, worker->connections.head);
+    }
+    file_cache_trim();
+    compress_cache_trim();
+    buffer_pool_trim();
+
+    return NULL;
+}
+
+static void close_worker(Worker *worker) {
+    if (worker->epoll_fd >= 0) close(worker->epoll_fd);
+    if (worker->server_fd >= 0) close(worker->server_fd);
+}
+
+int start_http_server(const ServerConfig *config) {
+    server_config = *config;
+    int port = config->port;
+    int worker_count = config->workers;
+
+    // 0 means "one worker per online CPU"
+    if (worker_count <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        worker_count = cpus > 0 ? (int)cpus : 1;
+    }
+    
+    printf("\n========================================\n");
+    printf("HTTP SERVER - Low Level Implementation\n");
+    printf("========================================\n\n");
+    
+    /* ============================================
+       SHUTDOWN NOTIFICATION
+       ============================================
+       Instead of waking up every second to check a flag, the
+       signal handler writes to an eventfd. The eventfd sits in
+       every worker's epoll set next to the sockets, so Ctrl+C wakes
+       all loops immediately and an idle server makes zero wakeups.
+       ============================================ */
+    shutdown_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (shutdown_fd < 0) {
+        perror("[ERROR] eventfd failed");
+        return -1;
+    }
+
+    // Set up signal handler for graceful shutdown
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+    
+    // Ignore SIGPIPE - handle broken pipe errors gracefully
+    // SIGPIPE is sent when writing to a closed socket
+    // Without this, the server crashes when a client disconnects early
+    signal(SIGPIPE, SIG_IGN);
+
+    Worker *workers = calloc(worker_count, sizeof(Worker));
+    if (!workers) {
+        close(shutdown_fd);
+        return -1;
+    }
+
+    // Bind every listener before starting any thread, so a port
+    // conflict is reported once and nothing is left half-running
+    int created = 0;
+    for (; created < worker_count; created++) {
+        Worker *worker = &workers[created];
+        worker->id = created;
+        worker->backend = config->backend;
+        worker->epoll_fd = -1;
+        worker->server_fd = create_listener(port, created == 0);
+        if (worker->server_fd < 0) break;
+
+        worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (worker->epoll_fd < 0) {
+            perror("[ERROR] epoll_create1 failed");
+            close_worker(worker);
+            break;
+        }
+    }
+
+    if (created < worker_count) {
+        for (int i = 0; i < created; i++) close_worker(&workers[i]);
+        free(workers);
+        close(shutdown_fd);
+        return -1;
+    }
     
+    // Pick the scanners now, while only one thread runs
+    HttpScanImpl json_scanner = http_scan_select(http_scan_best());
+    if (json_scanner == HTTP_SCAN_SCALAR) {
+        // The structural index is only worth it with SIMD to build it
+        json_index_min_bytes = (size_t)-1;
+    }
+
+    // Same for the embedded pages: render them before anyone reads them
+    if (routes_init() < 0) {
+        fprintf(stderr, "[ERROR] Out of memory rendering the embedded pages\n");
+        for (int i = 0; i < worker_count; i++) close_worker(&workers[i]);
+        free(workers);
+        close(shutdown_fd);
+        return -1;
+    }
+
     printf("\n✓ Server successfully started!\n");
     printf("✓ Listening on http://localhost:%d\n", port);
     printf("✓ Access from network: http://<your-ip>:%d\n", port);
+    printf("✓ Workers: %d (one SO_REUSEPORT listener + %s loop each)\n", worker_count,
+           config->backend == IO_BACKEND_IO_URING ? "io_uring" : "epoll");
+    printf("✓ Keep-alive: %ds idle timeout, %d requests per connection\n",
+           config->keepalive_timeout, config->max_requests);
+    printf("✓ JSON scanner: %s\n", http_scan_name(json_scanner));
     printf("\nEndpoints:\n");
     printf("  GET  /           - Home page\n");
     printf("  GET  /info       - Server information\n");
     printf("  GET  /image      - Serve an image\n");
+    printf("  GET  %s*  - Files from %s/\n", config->static_prefix, config->static_root);
     printf("  POST /echo       - Echo request body\n");
     printf("  POST /data       - Process data\n");
     printf("\nPress Ctrl+C to stop the server.\n");
     printf("========================================\n\n");
-    
+
     /* ============================================
-       MAIN SERVER LOOP
+       START THE WORKERS
        ============================================
-       This loop accepts and handles client connections
+       Each worker thread owns its listener, its epoll set and its
+       connections outright, so workers never share a lock on the
+       request path. The main thread just waits for them to exit.
        ============================================ */
-    while (server_running) {
-        struct sockaddr_in client_addr;
-        socklen_t client_addr_len = sizeof(client_addr);
-        int client_fd;
-        
-        /* ============================================
-           STEP 5: ACCEPT INCOMING CONNECTIONS
-           ============================================
-           accept() blocks until a client connects, then:
-           1. Completes the TCP 3-way handshake
-           2. Creates a NEW socket for this specific client
-           3. Returns the client's address information
-           
-           Why a new socket?
-           - server_fd stays listening for new connections
-           - client_fd is for communicating with THIS client
-           - This allows handling multiple clients
-           
-           The client_addr structure contains:
-           - sin_addr: Client's IP address (e.g., 191.124.29.0)
-           - sin_port: Client's source port (randomly assigned by OS)
-           ============================================ */
-        
-        // Use select() with timeout to allow checking server_running flag
-        fd_set readfds;
-        struct timeval tv;
-        FD_ZERO(&readfds);
-        FD_SET(server_fd, &readfds);
-        tv.tv_sec = 1;
-        tv.tv_usec = 0;
-        
-        int activity = select(server_fd + 1, &readfds, NULL, NULL, &tv);
-        
-        if (activity < 0 && errno != EINTR) {
-            perror("[ERROR] Select error");
+    int started = 0;
+    for (; started < worker_count; started++) {
+        if (pthread_create(&workers[started].thread, NULL, worker_main, &workers[started]) != 0) {
+            perror("[ERROR] pthread_create failed");
             break;
         }
-        
-        if (activity == 0) {
-            // Timeout - check if server should continue
-            continue;
-        }
-        
-        client_fd = accept(server_fd, (struct sockaddr *)&client_addr, &client_addr_len);
-        
-        if (client_fd < 0) {
-            if (errno != EINTR) {
-                perror("[ERROR] Accept failed");
-            }
-            continue;
-        }
-        
-        // Convert client IP address to human-readable format
-        char client_ip[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, INET_ADDRSTRLEN);
-        
-        printf("[CONNECTION] New connection from %s:%d\n", 
-               client_ip, ntohs(client_addr.sin_port));
-        
-        /* ============================================
-           STEP 6: HANDLE CLIENT REQUEST
-           ============================================
-           Now we can read the HTTP request from the client
-           and send back a response
-           ============================================ */
-        handle_client_connection(client_fd);
-        
-        /* ============================================
-           STEP 7: CLOSE CLIENT CONNECTION
-           ============================================
-           close() terminates the connection:
-           1. Sends TCP FIN packet to client
-           2. Releases the socket resources
-           3. Client receives FIN and closes their end
-           
-           This completes the TCP connection lifecycle:
-           SYN -> SYN-ACK -> ACK -> DATA -> FIN -> FIN-ACK
-           ============================================ */
-        close(client_fd);
-        printf("[CONNECTION] Connection closed\n\n");
     }
-    
-    close(server_fd);
+
+    if (started < worker_count) {
+        // Wake the threads that did start so they exit cleanly
+        uint64_t one = 1;
+        ssize_t ignored = write(shutdown_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    printf("\n[SERVER] Shutting down gracefully...\n");
+
+    for (int i = 0; i < worker_count; i++) {
+        close_worker(&workers[i]);
+    }
+    free(workers);
+    close(shutdown_fd);
+    routes_cleanup();
     printf("[SERVER] Server stopped.\n");
     
-    return 0;
-}
\ No newline at end of file
+    return started == worker_count ? 0 : -1;
+}
@@ -0,0 +1,490 @@
+#define _POSIX_C_SOURCE 200809L
+#include "http_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* ============================================
+   STATIC FILES
+   ============================================
+   Everything under server_config.static_prefix ("/static/" by
+   default) maps to a file below server_config.static_root:
+
+       GET /static/css/site.css  ->  <static_root>/css/site.css
+
+   Serving a file naively costs an open() and a stat() per request,
+   then the whole body even when the browser already has it. Two
+   things avoid that:
+
+   1. AN OPEN-FILE CACHE
+      Each worker keeps its most recently used files open, together
+      with their size, modification time and MIME type. A hit needs
+      no system call at all; the file is re-stat()ed at most every
+      FILE_CACHE_VALID_MS to notice when it changes on disk.
+
+   2. CONDITIONAL REQUESTS
+      Every response carries the file's version:
+          ETag: "5f3c1a2b-1e240"          (mtime-size)
+          Last-Modified: Tue, 18 Aug 2020 ...
+      A browser revalidating its copy sends them back:
+          If-None-Match: "5f3c1a2b-1e240"
+      If nothing changed we answer "304 Not Modified" with no body
+      at all, and the browser uses what it has.
+   ============================================ */
+
+#define STATIC_PATH_MAX 4096
+#define FILE_CACHE_BUCKETS 128   // Power of two, about twice FILE_CACHE_ENTRIES
+
+// Per thread, like the buffer pool: a worker only ever touches its own
+// cache, so no locking is needed
+typedef struct {
+    CachedFile *buckets[FILE_CACHE_BUCKETS];
+    CachedFile *lru_head;   // Most recently used
+    CachedFile *lru_tail;   // Next to be evicted
+    int count;
+} FileCache;
+
+static _Thread_local FileCache cache;
+
+// FNV-1a
+static unsigned hash_path(const char *path) {
+    unsigned h = 2166136261u;
+    for (; *path; path++) {
+        h = (h ^ (unsigned char)*path) * 16777619u;
+    }
+    return h & (FILE_CACHE_BUCKETS - 1);
+}
+
+static void lru_unlink(CachedFile *file) {
+    if (file->lru_prev) file->lru_prev->lru_next = file->lru_next;
+    else cache.lru_head = file->lru_next;
+    if (file->lru_next) file->lru_next->lru_prev = file->lru_prev;
+    else cache.lru_tail = file->lru_prev;
+    file->lru_prev = NULL;
+    file->lru_next = NULL;
+}
+
+static void lru_push_front(CachedFile *file) {
+    file->lru_next = cache.lru_head;
+    if (cache.lru_head) cache.lru_head->lru_prev = file;
+    else cache.lru_tail = file;
+    cache.lru_head = file;
+}
+
+// Make a file unreachable through the cache and drop the cache's
+// reference; responses still sending it keep it open
+static void cache_remove(CachedFile *file) {
+    CachedFile **link = &cache.buckets[hash_path(file->path)];
+    while (*link != file) link = &(*link)->hash_next;
+    *link = file->hash_next;
+
+    lru_unlink(file);
+    file->cached = 0;
+    cache.count--;
+    file_cache_release(file);
+}
+
+// Whether the file on disk is still the one we have open
+static int still_current(const CachedFile *file) {
+    struct stat st;
+    return stat(file->path, &st) == 0 &&
+           st.st_dev == file->device && st.st_ino == file->inode &&
+           (size_t)st.st_size == file->size && st.st_mtime == file->mtime;
+}
+
+static CachedFile *open_file(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    int error = 0;
+    if (fstat(fd, &st) < 0) error = errno;
+    else if (S_ISDIR(st.st_mode)) error = EISDIR;  // Caller may try index.html
+    else if (!S_ISREG(st.st_mode)) error = ENOENT;
+    if (error) {
+        close(fd);
+        errno = error;
+        return NULL;
+    }
+
+    CachedFile *file = calloc(1, sizeof(CachedFile));
+    if (file) file->path = strdup(path);
+    if (!file || !file->path) {
+        free(file);
+        close(fd);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    file->fd = fd;
+    file->size = (size_t)st.st_size;
+    file->mtime = st.st_mtime;
+    file->device = st.st_dev;
+    file->inode = st.st_ino;
+    file->mime_type = get_mime_type(path);
+    snprintf(file->etag, sizeof(file->etag), "\"%llx-%zx\"",
+             (unsigned long long)st.st_mtime, file->size);
+    http_format_date(st.st_mtime, file->last_modified, sizeof(file->last_modified));
+    return file;
+}
+
+CachedFile *file_cache_open(const char *path) {
+    long long now = connection_now_ms();
+    unsigned bucket = hash_path(path);
+
+    for (CachedFile *file = cache.buckets[bucket]; file; file = file->hash_next) {
+        if (strcmp(file->path, path) != 0) continue;
+
+        if (now - file->checked_ms > FILE_CACHE_VALID_MS) {
+            if (!still_current(file)) {
+                printf("[STATIC] %s changed on disk, reopening\n", path);
+                cache_remove(file);
+                break;
+            }
+            file->checked_ms = now;
+        }
+
+        lru_unlink(file);
+        lru_push_front(file);
+        file->refs++;
+        return file;
+    }
+
+    CachedFile *file = open_file(path);
+    if (!file) return NULL;
+
+    if (cache.count == FILE_CACHE_ENTRIES) {
+        cache_remove(cache.lru_tail);
+    }
+
+    file->refs = 2;  // The cache's and the caller's
+    file->cached = 1;
+    file->checked_ms = now;
+    file->hash_next = cache.buckets[bucket];
+    cache.buckets[bucket] = file;
+    lru_push_front(file);
+    cache.count++;
+    return file;
+}
+
+void file_cache_release(CachedFile *file) {
+    if (--file->refs > 0) return;
+
+    close(file->fd);
+    free(file->path);
+    free(file);
+}
+
+void file_cache_trim(void) {
+    while (cache.lru_head) {
+        cache_remove(cache.lru_head);
+    }
+}
+
+/* ============================================
+   PATH NORMALIZATION
+   ============================================
+   The URL path is attacker-controlled. "/static/../../etc/passwd"
+   (or its percent-encoded form "%2e%2e%2f") must never leave
+   static_root, so the path is decoded and resolved segment by
+   segment before it touches the filesystem:
+
+       css/./a/../site.css  ->  css/site.css
+       ../secret            ->  rejected (climbs above the root)
+
+   Hidden files (".git", ".env") are never served.
+   ============================================ */
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Append the normalized form of `path` to out (which already holds
+// static_root). Returns 0, or -1 if the path is invalid or escapes.
+static int normalize_path(HttpStr path, char *out, size_t out_len, size_t size) {
+    size_t root_len = out_len;
+
+    // Decode %XX escapes first, so an encoded "/" or "." cannot slip
+    // past the segment checks below
+    char decoded[STATIC_PATH_MAX];
+    size_t n = 0;
+    for (size_t i = 0; i < path.len; i++) {
+        char c = path.ptr[i];
+        if (c == '%') {
+            int hi = i + 2 < path.len ? hex_value(path.ptr[i + 1]) : -1;
+            int lo = hi >= 0 ? hex_value(path.ptr[i + 2]) : -1;
+            if (lo < 0) return -1;
+            c = (char)(hi * 16 + lo);
+            i += 2;
+        }
+        if (c == '\0' || c == '\\' || n + 1 >= sizeof(decoded)) return -1;
+        decoded[n++] = c;
+    }
+
+    size_t pos = 0;
+    while (pos < n) {
+        size_t start = pos;
+        while (pos < n && decoded[pos] != '/') pos++;
+        size_t len = pos - start;
+        const char *segment = decoded + start;
+        pos++;  // Skip the '/'
+
+        if (len == 0 || (len == 1 && segment[0] == '.')) continue;
+
+        if (len == 2 && segment[0] == '.' && segment[1] == '.') {
+            if (out_len == root_len) return -1;  // Would climb above static_root
+            while (out[out_len - 1] != '/') out_len--;
+            out_len--;  // Drop the '/' too
+            out[out_len] = '\0';
+            continue;
+        }
+
+        if (segment[0] == '.') return -1;  // Hidden file or directory
+        if (out_len + 1 + len + 1 > size) return -1;
+
+        out[out_len++] = '/';
+        memcpy(out + out_len, segment, len);
+        out_len += len;
+        out[out_len] = '\0';
+    }
+    return 0;
+}
+
+/* ============================================
+   CONDITIONAL REQUESTS
+   ============================================ */
+
+static int not_modified(const HttpRequest *request, const CachedFile *file) {
+    // If-None-Match wins when both are sent: ETags are more precise
+    HttpStr if_none_match = http_request_header(request, HDR_IF_NONE_MATCH);
+    if (if_none_match.len) {
+        return http_etag_matches(if_none_match, file->etag);
+    }
+
+    HttpStr if_modified_since = http_request_header(request, HDR_IF_MODIFIED_SINCE);
+    time_t since;
+    if (if_modified_since.len && http_parse_date(if_modified_since, &since) == 0) {
+        return file->mtime <= since;
+    }
+    return 0;
+}
+
+/* ============================================
+   RANGE REQUESTS
+   ============================================
+   A client resuming a download, or a video player seeking, asks
+   for just part of the file:
+
+       Range: bytes=1000-1999        the second kilobyte
+       Range: bytes=5000-            everything from byte 5000
+       Range: bytes=-500             the last 500 bytes
+       Range: bytes=0-99,-100        first and last 100 bytes
+
+   One range comes back as "206 Partial Content" with
+       Content-Range: bytes 1000-1999/<file size>
+   Several come back as one multipart/byteranges body, each part
+   with its own Content-Range. A Range that lies entirely past the
+   end of the file gets "416 Range Not Satisfiable".
+
+   If-Range guards a resumed download against the file changing in
+   between: the range is only honoured if the validator the client
+   sends (an ETag or a date) still matches; otherwise it gets the
+   whole, new file.
+
+   Each range is still sent with sendfile() straight from the file.
+   ============================================ */
+
+static int parse_number(const char **p, const char *end, unsigned long long *value) {
+    const char *start = *p;
+    unsigned long long n = 0;
+    while (*p < end && **p >= '0' && **p <= '9') {
+        if (n > (~0ULL - 9) / 10) return -1;
+        n = n * 10 + (unsigned)(**p - '0');
+        (*p)++;
+    }
+    *value = n;
+    return *p > start ? 0 : -1;
+}
+
+// Parse a Range header against a file of `size` bytes.
+// Returns the number of satisfiable ranges stored in `ranges`, 0 if
+// none is satisfiable (416), or -1 if the header should be ignored
+// (malformed, not bytes, or too many ranges).
+static int parse_ranges(HttpStr header, size_t size, HttpRange *ranges) {
+    const char *p = header.ptr;
+    const char *end = header.ptr + header.len;
+    if (header.len < 6 || strncasecmp(p, "bytes=", 6) != 0) return -1;
+    p += 6;
+
+    int count = 0;
+    int specs = 0;
+    for (;;) {
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        if (++specs > HTTP_MAX_RANGES) return -1;
+
+        unsigned long long first, last;
+        int satisfiable;
+        if (p < end && *p == '-') {
+            // Suffix range: the last N bytes
+            p++;
+            if (parse_number(&p, end, &last) < 0) return -1;
+            satisfiable = last > 0 && size > 0;
+            first = last >= size ? 0 : size - last;
+            last = size - 1;
+        } else {
+            if (parse_number(&p, end, &first) < 0 || p >= end || *p != '-') return -1;
+            p++;
+            if (p < end && *p >= '0' && *p <= '9') {
+                if (parse_number(&p, end, &last) < 0 || last < first) return -1;
+                if (last >= size) last = size - 1;
+            } else {
+                last = size - 1;  // Open-ended: to the end of the file
+            }
+            satisfiable = first < size;
+        }
+
+        if (satisfiable) {
+            ranges[count].offset = (off_t)first;
+            ranges[count].length = (size_t)(last - first + 1);
+            count++;
+        }
+
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        if (p == end) break;
+        if (*p != ',') return -1;
+        p++;
+    }
+    return count;
+}
+
+// If-Range: honour Range only if the file is still the version the
+// client has part of. Weak ETags never match here: the bytes must be
+// identical for the pieces to fit together.
+static int if_range_matches(const HttpRequest *request, const CachedFile *file) {
+    HttpStr if_range = http_request_header(request, HDR_IF_RANGE);
+    if (!if_range.len) return 1;
+
+    if (if_range.ptr[0] == '"') {
+        return if_range.len == strlen(file->etag) &&
+               memcmp(if_range.ptr, file->etag, if_range.len) == 0;
+    }
+    if (if_range.ptr[0] == 'W' && if_range.len > 1 && if_range.ptr[1] == '/') {
+        return 0;
+    }
+
+    time_t date;
+    return http_parse_date(if_range, &date) == 0 && date == file->mtime;
+}
+
+void http_serve_file(const HttpRequest *request, HttpResponse *response, CachedFile *file) {
+    snprintf(response->content_type, sizeof(response->content_type), "%s", file->mime_type);
+    http_response_add_header(response, "ETag", file->etag);
+    http_response_add_header(response, "Last-Modified", file->last_modified);
+
+    if (not_modified(request, file)) {
+        printf("[STATIC] %s not modified\n", file->path);
+        response->status_code = 304;
+        file_cache_release(file);
+        return;
+    }
+
+    http_response_add_header(response, "Accept-Ranges", "bytes");
+    response->status_code = 200;
+    response->body_mode = BODY_FILE;
+    response->body_fd = file->fd;
+    response->body_file = file;
+    response->body_offset = 0;
+    response->body_length = file->size;
+
+    HttpStr range = http_request_header(request, HDR_RANGE);
+    if (!range.len || !if_range_matches(request, file)) {
+        printf("[STATIC] Serving %s (%zu bytes)\n", file->path, file->size);
+        return;
+    }
+
+    HttpRange ranges[HTTP_MAX_RANGES];
+    int count = parse_ranges(range, file->size, ranges);
+    char content_range[96];
+
+    if (count < 0) {
+        printf("[STATIC] Ignoring Range: %.*s\n", (int)range.len, range.ptr);
+        printf("[STATIC] Serving %s (%zu bytes)\n", file->path, file->size);
+    } else if (count == 0) {
+        // Nothing we can send: tell the client how big the file really is
+        static const char message[] = "Range Not Satisfiable";
+        printf("[STATIC] Range not satisfiable: %.*s\n", (int)range.len, range.ptr);
+        snprintf(content_range, sizeof(content_range), "bytes */%zu", file->size);
+        http_response_add_header(response, "Content-Range", content_range);
+        file_cache_release(file);
+        response->status_code = 416;
+        response->body_fd = -1;
+        response->body_file = NULL;
+        strcpy(response->content_type, "text/plain");
+        http_response_set_static(response, message, sizeof(message) - 1);
+    } else if (count == 1) {
+        snprintf(content_range, sizeof(content_range), "bytes %lld-%lld/%zu",
+                 (long long)ranges[0].offset,
+                 (long long)ranges[0].offset + (long long)ranges[0].length - 1, file->size);
+        http_response_add_header(response, "Content-Range", content_range);
+        printf("[STATIC] Serving %s %s\n", file->path, content_range);
+        response->status_code = 206;
+        response->body_offset = ranges[0].offset;
+        response->body_length = ranges[0].length;
+    } else {
+        // send_http_response() writes the multipart framing around them
+        response->ranges = malloc(count * sizeof(HttpRange));
+        if (!response->ranges) {
+            printf("[STATIC] Serving %s (%zu bytes)\n", file->path, file->size);
+            return;
+        }
+        memcpy(response->ranges, ranges, count * sizeof(HttpRange));
+        response->range_count = count;
+        response->status_code = 206;
+        printf("[STATIC] Serving %s as %d ranges\n", file->path, count);
+    }
+}
+
+void handle_static(const HttpRequest *request, HttpResponse *response) {
+    size_t prefix_len = strlen(server_config.static_prefix);
+    HttpStr relative = {request->path.ptr + prefix_len, request->path.len - prefix_len};
+
+    char path[STATIC_PATH_MAX];
+    size_t root_len = strlen(server_config.static_root);
+    while (root_len > 1 && server_config.static_root[root_len - 1] == '/') root_len--;
+    if (root_len >= sizeof(path)) {
+        handle_not_found(request, response);
+        return;
+    }
+    memcpy(path, server_config.static_root, root_len);
+    path[root_len] = '\0';
+
+    if (normalize_path(relative, path, root_len, sizeof(path)) < 0) {
+        printf("[STATIC] Rejected path %.*s\n", (int)request->path.len, request->path.ptr);
+        handle_not_found(request, response);
+        return;
+    }
+
+    CachedFile *file = file_cache_open(path);
+    if (!file && errno == EISDIR) {
+        // A directory: serve its index page
+        size_t len = strlen(path);
+        if (len + sizeof("/index.html") <= sizeof(path)) {
+            memcpy(path + len, "/index.html", sizeof("/index.html"));
+            file = file_cache_open(path);
+        }
+    }
+    if (!file) {
+        handle_not_found(request, response);
+        return;
+    }
+
+    http_serve_file(request, response, file);
+}
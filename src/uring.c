@@ -0,0 +1,742 @@
+#define _GNU_SOURCE
+#include "http_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <linux/io_uring.h>
+
+/* ============================================
+   IO_URING BACKEND
+   ============================================
+   epoll tells us WHEN a socket is ready, and we still make one
+   syscall per recv()/send(). io_uring flips this around: we put
+   requests ("accept on this fd", "receive on that fd") into a
+   submission queue shared with the kernel, and the kernel posts
+   results into a completion queue. One io_uring_enter() call
+   submits a whole batch and waits for the next results.
+
+   Two features keep syscalls per request low:
+   - Multishot accept: ONE request keeps producing a completion
+     for every new client until cancelled
+   - Multishot recv + provided buffer ring: ONE request per client
+     keeps receiving; the kernel picks a free buffer from a ring we
+     registered up front, so no buffer is pinned per idle client
+
+   Needs Linux 6.0+. On older kernels setup or the first multishot
+   accept fails, and the worker falls back to the epoll loop.
+   ============================================ */
+
+#define URING_ENTRIES     1024
+#define RECV_BUF_COUNT    256    // Must be a power of two
+#define RECV_BUF_SIZE     4096
+#define RECV_BUF_GROUP    0
+
+// Operation kind, stored in the low bits of each SQE's user_data.
+// Connection structs come from malloc() so their low 3 bits are free.
+enum {
+    OP_ACCEPT = 1,
+    OP_RECV = 2,
+    OP_SEND = 3,
+    OP_SHUTDOWN = 4,
+    OP_TIMEOUT = 5,
+    OP_WRITABLE = 6,
+    OP_CANCEL = 7,
+};
+#define OP_MASK 7ULL
+
+typedef struct {
+    int ring_fd;
+
+    // Submission queue (shared with the kernel)
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+    unsigned sq_pending;   // SQEs written but not yet submitted
+    unsigned inflight;     // Operations whose final completion has not arrived
+
+    // Completion queue (shared with the kernel)
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    void *sq_ring_ptr;
+    size_t sq_ring_size;
+    void *cq_ring_ptr;
+    size_t cq_ring_size;
+    size_t sqes_size;
+
+    // Provided buffers for multishot recv
+    struct io_uring_buf_ring *buf_ring;
+    size_t buf_ring_size;
+    char *recv_buffers;
+
+    int worker_id;
+    int server_fd;
+    int accepted_any;
+    ConnectionList connections;  // Least recently active first
+
+    // Idle-connection timer; only armed while there are connections
+    struct __kernel_timespec timer;
+    int timer_armed;
+} Uring;
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/* ============================================
+   RING SETUP / TEARDOWN
+   ============================================ */
+
+static void uring_destroy(Uring *ring) {
+    if (ring->buf_ring) munmap(ring->buf_ring, ring->buf_ring_size);
+    free(ring->recv_buffers);
+    if (ring->sqes) munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring_ptr && ring->cq_ring_ptr != ring->sq_ring_ptr) {
+        munmap(ring->cq_ring_ptr, ring->cq_ring_size);
+    }
+    if (ring->sq_ring_ptr) munmap(ring->sq_ring_ptr, ring->sq_ring_size);
+    if (ring->ring_fd >= 0) close(ring->ring_fd);
+}
+
+static int uring_setup(Uring *ring) {
+    struct io_uring_params params;
+
+    // The worker thread is the only submitter, which lets the kernel
+    // skip some locking; older kernels reject these flags, so retry plain
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+    ring->ring_fd = sys_io_uring_setup(URING_ENTRIES, &params);
+    if (ring->ring_fd < 0 && errno == EINVAL) {
+        memset(&params, 0, sizeof(params));
+        ring->ring_fd = sys_io_uring_setup(URING_ENTRIES, &params);
+    }
+    if (ring->ring_fd < 0) {
+        return -1;
+    }
+
+    // Map the two rings and the SQE array into our address space
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_ring_size > ring->sq_ring_size) ring->sq_ring_size = ring->cq_ring_size;
+        ring->cq_ring_size = ring->sq_ring_size;
+    }
+
+    ring->sq_ring_ptr = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring_ptr == MAP_FAILED) {
+        ring->sq_ring_ptr = NULL;
+        return -1;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ring_ptr = ring->sq_ring_ptr;
+    } else {
+        ring->cq_ring_ptr = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring_ptr == MAP_FAILED) {
+            ring->cq_ring_ptr = NULL;
+            return -1;
+        }
+    }
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        return -1;
+    }
+
+    char *sq = ring->sq_ring_ptr;
+    ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+
+    char *cq = ring->cq_ring_ptr;
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    // SQ slot i always holds SQE i, so the indirection array is fixed
+    for (unsigned i = 0; i <= *ring->sq_mask; i++) {
+        ring->sq_array[i] = i;
+    }
+
+    /* ============================================
+       PROVIDED BUFFER RING
+       ============================================
+       Instead of handing the kernel a buffer per recv request, we
+       register a pool of RECV_BUF_COUNT buffers. Each completion
+       says which buffer it filled; we copy the bytes out and give
+       the buffer straight back to the ring.
+       ============================================ */
+    ring->buf_ring_size = RECV_BUF_COUNT * sizeof(struct io_uring_buf);
+    ring->buf_ring = mmap(NULL, ring->buf_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring->buf_ring == MAP_FAILED) {
+        ring->buf_ring = NULL;
+        return -1;
+    }
+
+    ring->recv_buffers = malloc((size_t)RECV_BUF_COUNT * RECV_BUF_SIZE);
+    if (!ring->recv_buffers) {
+        return -1;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)ring->buf_ring;
+    reg.ring_entries = RECV_BUF_COUNT;
+    reg.bgid = RECV_BUF_GROUP;
+    if (sys_io_uring_register(ring->ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        return -1;
+    }
+
+    for (unsigned bid = 0; bid < RECV_BUF_COUNT; bid++) {
+        struct io_uring_buf *buf = &ring->buf_ring->bufs[bid];
+        buf->addr = (uint64_t)(uintptr_t)(ring->recv_buffers + (size_t)bid * RECV_BUF_SIZE);
+        buf->len = RECV_BUF_SIZE;
+        buf->bid = bid;
+    }
+    __atomic_store_n(&ring->buf_ring->tail, RECV_BUF_COUNT, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+// Hand a consumed receive buffer back to the kernel
+static void recycle_buffer(Uring *ring, unsigned bid) {
+    unsigned short tail = ring->buf_ring->tail;
+    struct io_uring_buf *buf = &ring->buf_ring->bufs[tail & (RECV_BUF_COUNT - 1)];
+    buf->addr = (uint64_t)(uintptr_t)(ring->recv_buffers + (size_t)bid * RECV_BUF_SIZE);
+    buf->len = RECV_BUF_SIZE;
+    buf->bid = bid;
+    __atomic_store_n(&ring->buf_ring->tail, (unsigned short)(tail + 1), __ATOMIC_RELEASE);
+}
+
+/* ============================================
+   SUBMISSION HELPERS
+   ============================================ */
+
+static int uring_submit(Uring *ring, unsigned wait_for) {
+    unsigned flags = wait_for ? IORING_ENTER_GETEVENTS : 0;
+    for (;;) {
+        int ret = sys_io_uring_enter(ring->ring_fd, ring->sq_pending, wait_for, flags);
+        if (ret >= 0) {
+            ring->sq_pending -= (unsigned)ret < ring->sq_pending ? (unsigned)ret : ring->sq_pending;
+            return 0;
+        }
+        if (errno == EINTR) continue;
+        return -1;
+    }
+}
+
+static struct io_uring_sqe *get_sqe(Uring *ring) {
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    unsigned tail = *ring->sq_tail;
+
+    if (tail - head > *ring->sq_mask) {
+        // Submission queue full: push what we have to the kernel first
+        if (uring_submit(ring, 0) == 0) head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        if (tail - head > *ring->sq_mask) {
+            fprintf(stderr, "[URING] Worker %d: submission queue full\n", ring->worker_id);
+            return NULL;
+        }
+    }
+
+    struct io_uring_sqe *sqe = &ring->sqes[tail & *ring->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->sq_pending++;
+    ring->inflight++;
+    return sqe;
+}
+
+static uint64_t make_user_data(void *ptr, unsigned op) {
+    return (uint64_t)(uintptr_t)ptr | op;
+}
+
+static void queue_accept(Uring *ring) {
+    struct io_uring_sqe *sqe = get_sqe(ring);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = ring->server_fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = make_user_data(NULL, OP_ACCEPT);
+}
+
+static void queue_shutdown_poll(Uring *ring, int shutdown_fd) {
+    struct io_uring_sqe *sqe = get_sqe(ring);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = shutdown_fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = make_user_data(NULL, OP_SHUTDOWN);
+}
+
+// The per-connection helpers return -1 if no SQE could be had: the
+// operation was not queued, and nothing would ever retry it, so the
+// caller closes the connection rather than leave it stalled
+static int queue_recv(Uring *ring, Connection *conn) {
+    struct io_uring_sqe *sqe = get_sqe(ring);
+    if (!sqe) return -1;
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = conn->fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = RECV_BUF_GROUP;
+    sqe->user_data = make_user_data(conn, OP_RECV);
+    conn->pending_ops++;
+    return 0;
+}
+
+// Queue the connection's unsent response segments as one SENDMSG (one
+// in flight at a time). The iovec array and msghdr live in the
+// connection because the kernel reads them after this returns.
+static int queue_sendmsg(Uring *ring, Connection *conn) {
+    struct io_uring_sqe *sqe = get_sqe(ring);
+    if (!sqe) return -1;
+
+    memset(&conn->send_msg, 0, sizeof(conn->send_msg));
+    conn->send_msg.msg_iov = conn->send_iov;
+    conn->send_msg.msg_iovlen = connection_output_iov(conn, conn->send_iov, OUTPUT_IOV_MAX);
+
+    // Stopped at a file segment: let the headers wait for its first bytes
+    size_t next = conn->output_head + conn->send_msg.msg_iovlen;
+    int more = next < conn->output_count && conn->output[next].fd >= 0;
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = conn->fd;
+    sqe->addr = (uint64_t)(uintptr_t)&conn->send_msg;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL | (more ? MSG_MORE : 0);
+    sqe->user_data = make_user_data(conn, OP_SEND);
+    conn->pending_ops++;
+    conn->sending = 1;
+    return 0;
+}
+
+// Wait until the socket can take more file bytes
+static int queue_writable(Uring *ring, Connection *conn) {
+    struct io_uring_sqe *sqe = get_sqe(ring);
+    if (!sqe) return -1;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = conn->fd;
+    sqe->poll32_events = POLLOUT;
+    sqe->user_data = make_user_data(conn, OP_WRITABLE);
+    conn->pending_ops++;
+    conn->sending = 1;
+    return 0;
+}
+
+/* ============================================
+   FILE SEGMENTS
+   ============================================
+   io_uring has no sendfile operation. Memory segments still go out
+   as a SENDMSG, but when a file segment reaches the head of the
+   queue we call sendfile() right here: the socket is non-blocking,
+   so it sends what fits and returns. If the socket fills up we ask
+   the ring to tell us when it is writable (POLL_ADD for POLLOUT)
+   and carry on from there.
+   ============================================ */
+
+// Start sending the output queue.
+// Returns 1 if it drained right away, 0 if a send or wait is now in
+// flight, -1 if the socket failed or the ring had no room for the op.
+static int queue_send(Uring *ring, Connection *conn) {
+    while (connection_has_pending_output(conn)) {
+        if (!connection_output_is_file(conn)) {
+            return queue_sendmsg(ring, conn);
+        }
+
+        int status = connection_send_file(conn);
+        if (status < 0) return -1;
+        if (status == 0) {
+            return queue_writable(ring, conn);
+        }
+    }
+    return 1;
+}
+
+// Wake up after `ms` so idle keep-alive connections can be closed
+static void queue_timeout(Uring *ring, long long ms) {
+    struct io_uring_sqe *sqe = get_sqe(ring);
+    if (!sqe) return;
+    ring->timer.tv_sec = ms / 1000;
+    ring->timer.tv_nsec = (ms % 1000) * 1000000;
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->addr = (uint64_t)(uintptr_t)&ring->timer;
+    sqe->len = 1;
+    sqe->user_data = make_user_data(NULL, OP_TIMEOUT);
+    ring->timer_armed = 1;
+}
+
+/* ============================================
+   CONNECTION LIFECYCLE
+   ============================================
+   The kernel may still hold a multishot recv or a send for a
+   connection, referencing its memory. So "close" means: shut the
+   socket down (which makes the armed recv complete), and only free
+   the struct once every outstanding operation has reported back.
+   ============================================ */
+
+static void release_connection(Uring *ring, Connection *conn) {
+    if (conn->pending_ops > 0) return;
+    connection_list_remove(&ring->connections, conn);
+    connection_destroy(conn);
+    printf("[CONNECTION] Connection closed\n\n");
+}
+
+static void close_connection(Uring *ring, Connection *conn) {
+    if (!conn->closing) {
+        conn->closing = 1;
+        shutdown(conn->fd, SHUT_RDWR);
+    }
+    release_connection(ring, conn);
+}
+
+// After new request bytes arrived (or the previous response finished):
+// parse, route, and start sending
+static void service_connection(Uring *ring, Connection *conn) {
+    for (;;) {
+        handle_client_connection(conn);
+
+        // A send already in flight will queue the rest when it completes
+        if (!connection_has_pending_output(conn) || conn->sending) return;
+
+        int status = queue_send(ring, conn);
+        if (status < 0) {
+            close_connection(ring, conn);
+            return;
+        }
+        if (status == 0) return;
+
+        // Sent on the spot (all file segments): move on to the next request
+        if (connection_finished(conn)) {
+            close_connection(ring, conn);
+            return;
+        }
+    }
+}
+
+// The previous send finished: queue what is left, or move on
+static void continue_send(Uring *ring, Connection *conn) {
+    connection_list_touch(&ring->connections, conn);
+
+    if (connection_has_pending_output(conn)) {
+        // Short send, or more segments than one SENDMSG takes: queue the rest
+        int status = queue_send(ring, conn);
+        if (status < 0) {
+            close_connection(ring, conn);
+            return;
+        }
+        if (status == 0) return;
+    }
+
+    if (connection_finished(conn)) {
+        close_connection(ring, conn);
+    } else {
+        // Keep-alive (or more of a streamed body): the next request may
+        // already be buffered
+        service_connection(ring, conn);
+    }
+}
+
+/* ============================================
+   COMPLETION HANDLERS
+   ============================================ */
+
+static void on_accept(Uring *ring, struct io_uring_cqe *cqe) {
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        // Multishot accept ended (error or overflow) - re-arm it
+        if (cqe->res == -EINVAL && !ring->accepted_any) {
+            return;  // Kernel lacks multishot accept; caller falls back
+        }
+        queue_accept(ring);
+    }
+
+    if (cqe->res < 0) {
+        if (cqe->res != -EINVAL) {
+            fprintf(stderr, "[ERROR] Accept failed: %s\n", strerror(-cqe->res));
+        }
+        return;
+    }
+
+    ring->accepted_any = 1;
+    int client_fd = cqe->res;
+
+    // Multishot accept shares one address buffer, so ask per client
+    struct sockaddr_in client_addr;
+    socklen_t client_addr_len = sizeof(client_addr);
+    char client_ip[INET_ADDRSTRLEN] = "unknown";
+    int client_port = 0;
+    if (getpeername(client_fd, (struct sockaddr *)&client_addr, &client_addr_len) == 0) {
+        inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, INET_ADDRSTRLEN);
+        client_port = ntohs(client_addr.sin_port);
+    }
+
+    printf("[CONNECTION] Worker %d: new connection from %s:%d (io_uring)\n",
+           ring->worker_id, client_ip, client_port);
+
+    Connection *conn = connection_create(client_fd, client_ip);
+    if (!conn) {
+        fprintf(stderr, "[ERROR] Out of memory for connection\n");
+        close(client_fd);
+        return;
+    }
+
+    connection_list_add(&ring->connections, conn);
+    if (queue_recv(ring, conn) < 0) {
+        close_connection(ring, conn);
+        return;
+    }
+
+    if (!ring->timer_armed) {
+        queue_timeout(ring, (long long)server_config.keepalive_timeout * 1000);
+    }
+}
+
+static void on_recv(Uring *ring, Connection *conn, struct io_uring_cqe *cqe) {
+    int more = cqe->flags & IORING_CQE_F_MORE;
+    int peer_gone = 0;
+    if (!more) {
+        conn->pending_ops--;
+    }
+
+    if (cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+        unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+        const char *data = ring->recv_buffers + (size_t)bid * RECV_BUF_SIZE;
+
+        // Copy into the connection's request buffer, then return the
+        // ring buffer to the kernel right away
+        int fits = connection_reserve_read(conn, cqe->res) == 0;
+        if (fits) {
+            memcpy(conn->read_buffer + conn->read_length, data, cqe->res);
+            conn->read_length += cqe->res;
+            conn->read_buffer[conn->read_length] = '\0';
+        }
+        recycle_buffer(ring, bid);
+
+        if (!fits) {
+            // Request larger than any we accept - drop the client
+            if (!conn->closing) close_connection(ring, conn);
+        } else if (!conn->closing) {
+            connection_list_touch(&ring->connections, conn);
+            service_connection(ring, conn);
+        }
+    } else if (cqe->res != -ENOBUFS) {
+        // EOF (res == 0) or error: this client will send nothing more
+        peer_gone = 1;
+    }
+
+    if (more) {
+        return;
+    }
+
+    if (conn->closing) {
+        release_connection(ring, conn);
+    } else if (peer_gone) {
+        // Let an in-flight response finish; its completion closes us
+        conn->close_after_write = 1;
+        if (!connection_has_pending_output(conn)) {
+            close_connection(ring, conn);
+        }
+    } else {
+        // Multishot recv stopped (e.g. ENOBUFS when every provided
+        // buffer was busy) - re-arm it
+        if (queue_recv(ring, conn) < 0) close_connection(ring, conn);
+    }
+}
+
+static void on_send(Uring *ring, Connection *conn, struct io_uring_cqe *cqe) {
+    conn->pending_ops--;
+    conn->sending = 0;
+
+    if (cqe->res < 0 || conn->closing) {
+        close_connection(ring, conn);
+        return;
+    }
+
+    connection_advance_output(conn, (size_t)cqe->res);
+    continue_send(ring, conn);
+}
+
+// The socket has room again for the file segment at the queue head
+static void on_writable(Uring *ring, Connection *conn, struct io_uring_cqe *cqe) {
+    conn->pending_ops--;
+    conn->sending = 0;
+
+    if (cqe->res < 0 || conn->closing) {
+        close_connection(ring, conn);
+        return;
+    }
+
+    continue_send(ring, conn);
+}
+
+// Timer fired: close connections idle too long, then re-arm for the
+// next one to expire (the list is ordered by last activity)
+static void on_timeout(Uring *ring) {
+    long long timeout_ms = (long long)server_config.keepalive_timeout * 1000;
+    long long now = connection_now_ms();
+    ring->timer_armed = 0;
+
+    Connection *conn = ring->connections.head;
+    while (conn) {
+        Connection *next = conn->next;
+        long long idle = now - conn->last_active_ms;
+        if (idle < timeout_ms) {
+            queue_timeout(ring, timeout_ms - idle);
+            return;
+        }
+        if (!conn->closing) {
+            printf("[CONNECTION] Closing idle connection from %s\n", conn->client_ip);
+            close_connection(ring, conn);
+        }
+        conn = next;
+    }
+}
+
+// Cancel every operation still in flight and wait for all their final
+// completions. Closing the ring fd alone is not enough: the kernel
+// tears the ring down asynchronously, with the operations still live.
+static int uring_drain(Uring *ring) {
+    // Shutting the sockets down ends their recvs and sends; the cancel
+    // catches everything else (accept, polls, the timer)
+    for (Connection *conn = ring->connections.head; conn; conn = conn->next) {
+        shutdown(conn->fd, SHUT_RDWR);
+    }
+    struct io_uring_sqe *sqe = get_sqe(ring);
+    if (!sqe) return -1;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+    sqe->user_data = make_user_data(NULL, OP_CANCEL);
+
+    while (ring->inflight > 0) {
+        if (uring_submit(ring, 1) < 0) return -1;
+
+        unsigned head = *ring->cq_head;
+        unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            if (!(ring->cqes[head & *ring->cq_mask].flags & IORING_CQE_F_MORE)) ring->inflight--;
+        }
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+    return 0;
+}
+
+/* ============================================
+   THE LOOP
+   ============================================ */
+
+int run_io_uring_loop(int worker_id, int server_fd, int shutdown_fd) {
+    Uring ring;
+    memset(&ring, 0, sizeof(ring));
+    ring.ring_fd = -1;
+    ring.worker_id = worker_id;
+    ring.server_fd = server_fd;
+
+    if (uring_setup(&ring) < 0) {
+        fprintf(stderr, "[URING] Worker %d: io_uring setup failed: %s\n",
+                worker_id, strerror(errno));
+        uring_destroy(&ring);
+        return -1;
+    }
+
+    queue_shutdown_poll(&ring, shutdown_fd);
+    queue_accept(&ring);
+
+    int running = 1;
+    int result = 0;
+
+    while (running) {
+        // Submit everything queued and sleep until a completion arrives
+        if (uring_submit(&ring, 1) < 0) {
+            perror("[ERROR] io_uring_enter failed");
+            result = ring.accepted_any ? 0 : -1;
+            break;
+        }
+
+        unsigned head = *ring.cq_head;
+        unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+
+        while (head != tail) {
+            struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+            unsigned op = cqe->user_data & OP_MASK;
+            Connection *conn = (Connection *)(uintptr_t)(cqe->user_data & ~OP_MASK);
+            if (!(cqe->flags & IORING_CQE_F_MORE)) ring.inflight--;
+
+            switch (op) {
+            case OP_ACCEPT:
+                if (cqe->res == -EINVAL && !ring.accepted_any) {
+                    fprintf(stderr, "[URING] Worker %d: multishot accept unsupported\n",
+                            worker_id);
+                    running = 0;
+                    result = -1;
+                } else {
+                    on_accept(&ring, cqe);
+                }
+                break;
+            case OP_RECV:
+                on_recv(&ring, conn, cqe);
+                break;
+            case OP_SEND:
+                on_send(&ring, conn, cqe);
+                break;
+            case OP_WRITABLE:
+                on_writable(&ring, conn, cqe);
+                break;
+            case OP_TIMEOUT:
+                on_timeout(&ring);
+                break;
+            case OP_SHUTDOWN:
+                running = 0;
+                break;
+            }
+
+            head++;
+        }
+
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    // Freeing anything the kernel may still read or write into (a
+    // connection's send message, the receive buffers, the timer) must
+    // wait until every operation has completed
+    if (uring_drain(&ring) < 0) {
+        fprintf(stderr, "[URING] Worker %d: could not drain the ring, leaking it\n", worker_id);
+        return result;
+    }
+    while (ring.connections.head) {
+        Connection *conn = ring.connections.head;
+        connection_list_remove(&ring.connections, conn);
+        connection_destroy(conn);
+    }
+
+    uring_destroy(&ring);
+    return result;
+}
@@ -1,38 +1,138 @@
+#define _POSIX_C_SOURCE 200809L
 #include "http_server.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <ctype.h>
+#include <time.h>
 
-unsigned char *read_image_file(const char *filename, size_t *size) {
-    FILE *file = fopen(filename, "rb");
-    if (!file) {
-        printf("[FILE] Could not open file: %s\n", filename);
-        return NULL;
+int http_str_equals(HttpStr str, const char *literal) {
+    size_t len = strlen(literal);
+    return str.len == len && memcmp(str.ptr, literal, len) == 0;
+}
+
+int http_str_case_equals(HttpStr str, const char *literal) {
+    size_t len = strlen(literal);
+    if (str.len != len) return 0;
+    for (size_t i = 0; i < len; i++) {
+        if (tolower((unsigned char)str.ptr[i]) != tolower((unsigned char)literal[i])) {
+            return 0;
+        }
     }
-    
-    // Get file size
-    fseek(file, 0, SEEK_END);
-    *size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    
-    // Allocate memory
-    unsigned char *data = malloc(*size);
-    if (!data) {
-        fclose(file);
-        return NULL;
+    return 1;
+}
+
+int http_str_has_prefix(HttpStr str, const char *prefix) {
+    size_t len = strlen(prefix);
+    return str.len >= len && memcmp(str.ptr, prefix, len) == 0;
+}
+
+// If-None-Match holds "*" or a comma-separated list of ETags. Weak
+// ones (W/"...") still count: a 304 only needs the same content.
+int http_etag_matches(HttpStr list, const char *etag) {
+    size_t etag_len = strlen(etag);
+    size_t pos = 0;
+
+    while (pos < list.len) {
+        while (pos < list.len && (list.ptr[pos] == ' ' || list.ptr[pos] == ',')) pos++;
+        size_t start = pos;
+        while (pos < list.len && list.ptr[pos] != ',') pos++;
+        size_t end = pos;
+        while (end > start && list.ptr[end - 1] == ' ') end--;
+
+        const char *tag = list.ptr + start;
+        size_t len = end - start;
+        if (len == 1 && tag[0] == '*') return 1;
+        if (len > 2 && tag[0] == 'W' && tag[1] == '/') {
+            tag += 2;
+            len -= 2;
+        }
+        if (len == etag_len && memcmp(tag, etag, len) == 0) return 1;
     }
-    
-    // Read file
-    size_t bytes_read = fread(data, 1, *size, file);
-    fclose(file);
-    
-    if (bytes_read != *size) {
-        free(data);
-        return NULL;
+    return 0;
+}
+
+// Accept-Encoding: gzip;q=0.8, br, *;q=0
+// A coding named explicitly wins over "*"; q=0 means "never send this".
+int http_accepts_encoding(HttpStr accept_encoding, const char *coding) {
+    size_t coding_len = strlen(coding);
+    int wildcard = 0;
+    size_t pos = 0;
+
+    while (pos < accept_encoding.len) {
+        while (pos < accept_encoding.len &&
+               (accept_encoding.ptr[pos] == ' ' || accept_encoding.ptr[pos] == ',')) pos++;
+        size_t start = pos;
+        while (pos < accept_encoding.len && accept_encoding.ptr[pos] != ',') pos++;
+        HttpStr item = {accept_encoding.ptr + start, pos - start};
+
+        // Name up to ';' or whitespace, then an optional q= weight
+        size_t name_len = 0;
+        while (name_len < item.len && item.ptr[name_len] != ';' && item.ptr[name_len] != ' ') {
+            name_len++;
+        }
+        int allowed = 1;
+        const char *q = memchr(item.ptr, '=', item.len);
+        if (q && q > item.ptr && (q[-1] == 'q' || q[-1] == 'Q')) {
+            // "q=0", "q=0.0", "q=0.000" all mean not acceptable
+            allowed = 0;
+            for (const char *p = q + 1; p < item.ptr + item.len && *p != ' ' && *p != ';'; p++) {
+                if (*p >= '1' && *p <= '9') allowed = 1;
+            }
+        }
+
+        if (name_len == coding_len && strncasecmp(item.ptr, coding, coding_len) == 0) {
+            return allowed;
+        }
+        if (name_len == 1 && item.ptr[0] == '*') wildcard = allowed;
     }
-    
-    return data;
+    return wildcard;
+}
+
+static const char *const month_names[12] = {
+    "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+void http_format_date(time_t t, char *out, size_t size) {
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(out, size, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+}
+
+int http_parse_date(HttpStr value, time_t *t) {
+    // "Sun, 06 Nov 1994 08:49:37 GMT" is always 29 bytes
+    char text[30];
+    if (value.len != 29) return -1;
+    memcpy(text, value.ptr, 29);
+    text[29] = '\0';
+
+    char month_name[4];
+    int day, year, hour, minute, second, used = 0;
+    if (sscanf(text, "%*3s, %2d %3s %4d %2d:%2d:%2d GMT%n",
+               &day, month_name, &year, &hour, &minute, &second, &used) != 6 || used != 29) {
+        return -1;
+    }
+
+    int month = -1;
+    for (int i = 0; i < 12; i++) {
+        if (strcmp(month_name, month_names[i]) == 0) month = i + 1;
+    }
+    if (month < 0 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return -1;
+    }
+
+    // Days since 1970-01-01 in the proleptic Gregorian calendar, counting
+    // years from March so the leap day falls at the end
+    int y = year - (month <= 2);
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long year_of_era = y - era * 400;
+    long day_of_year = (153L * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    long days = era * 146097 + day_of_era - 719468;
+
+    *t = (time_t)days * 86400 + hour * 3600 + minute * 60 + second;
+    return 0;
 }
 
 void url_decode(char *str) {
@@ -60,31 +160,48 @@ void url_decode(char *str) {
     *write = '\0';
 }
 
+// Looked up once per file opened: CachedFile keeps the result
+static const struct {
+    const char *extension;
+    const char *mime_type;
+} mime_types[] = {
+    {"html", "text/html; charset=utf-8"},
+    {"htm", "text/html; charset=utf-8"},
+    {"css", "text/css; charset=utf-8"},
+    {"js", "application/javascript; charset=utf-8"},
+    {"mjs", "application/javascript; charset=utf-8"},
+    {"json", "application/json"},
+    {"txt", "text/plain; charset=utf-8"},
+    {"md", "text/markdown; charset=utf-8"},
+    {"xml", "application/xml"},
+    {"png", "image/png"},
+    {"jpg", "image/jpeg"},
+    {"jpeg", "image/jpeg"},
+    {"gif", "image/gif"},
+    {"webp", "image/webp"},
+    {"svg", "image/svg+xml"},
+    {"ico", "image/x-icon"},
+    {"woff", "font/woff"},
+    {"woff2", "font/woff2"},
+    {"wasm", "application/wasm"},
+    {"pdf", "application/pdf"},
+    {"zip", "application/zip"},
+    {"gz", "application/gzip"},
+    {"mp3", "audio/mpeg"},
+    {"mp4", "video/mp4"},
+    {"webm", "video/webm"},
+};
+
 const char *get_mime_type(const char *filename) {
-    const char *ext = strrchr(filename, '.');
+    const char *slash = strrchr(filename, '/');
+    const char *ext = strrchr(slash ? slash : filename, '.');
     if (!ext) return "application/octet-stream";
-    
-    if (strcmp(ext, ".html") == 0 || strcmp(ext, ".htm") == 0) {
-        return "text/html";
-    } else if (strcmp(ext, ".css") == 0) {
-        return "text/css";
-    } else if (strcmp(ext, ".js") == 0) {
-        return "application/javascript";
-    } else if (strcmp(ext, ".json") == 0) {
-        return "application/json";
-    } else if (strcmp(ext, ".png") == 0) {
-        return "image/png";
-    } else if (strcmp(ext, ".jpg") == 0 || strcmp(ext, ".jpeg") == 0) {
-        return "image/jpeg";
-    } else if (strcmp(ext, ".gif") == 0) {
-        return "image/gif";
-    } else if (strcmp(ext, ".svg") == 0) {
-        return "image/svg+xml";
-    } else if (strcmp(ext, ".txt") == 0) {
-        return "text/plain";
-    } else if (strcmp(ext, ".pdf") == 0) {
-        return "application/pdf";
+    ext++;
+
+    for (size_t i = 0; i < sizeof(mime_types) / sizeof(mime_types[0]); i++) {
+        if (strcasecmp(ext, mime_types[i].extension) == 0) {
+            return mime_types[i].mime_type;
+        }
     }
-    
     return "application/octet-stream";
-}
\ No newline at end of file
+}
@@ -0,0 +1,202 @@
+/* ============================================
+   EMBED ASSETS (build-time tool)
+   ============================================
+   Turns the files in assets/ into a C source file, so the pages
+   are part of the server binary instead of string literals spread
+   through the code:
+
+       build/embed_assets build/assets.c assets assets/index.html ...
+
+   For every file it writes:
+   - the bytes, as a const array (its length is a compile-time
+     constant, no strlen() at runtime)
+   - a content hash, used as the ETag
+   - a gzip-compressed copy, when that is actually smaller
+
+   The output only depends on the file contents (no timestamps), so
+   rebuilding the same assets gives the same binary.
+   ============================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+typedef struct {
+    const char *path;   // As given on the command line
+    const char *name;   // Relative to the asset directory
+} AssetFile;
+
+static unsigned char *read_file(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    size_t capacity = 65536;
+    size_t used = 0;
+    unsigned char *data = malloc(capacity);
+    while (data) {
+        used += fread(data + used, 1, capacity - used, file);
+        if (used < capacity) break;
+        capacity *= 2;
+        unsigned char *bigger = realloc(data, capacity);
+        if (!bigger) free(data);
+        data = bigger;
+    }
+
+    int failed = ferror(file);
+    fclose(file);
+    if (failed) {
+        free(data);
+        return NULL;
+    }
+    *length = used;
+    return data;
+}
+
+// gzip at the highest level; zlib writes a zero timestamp in the header
+static unsigned char *gzip_bytes(const unsigned char *data, size_t length, size_t *gzip_length) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        return NULL;
+    }
+
+    size_t capacity = deflateBound(&stream, length);
+    unsigned char *out = malloc(capacity);
+    if (!out) {
+        deflateEnd(&stream);
+        return NULL;
+    }
+
+    stream.next_in = (unsigned char *)data;
+    stream.avail_in = (uInt)length;
+    stream.next_out = out;
+    stream.avail_out = (uInt)capacity;
+    int status = deflate(&stream, Z_FINISH);
+    *gzip_length = stream.total_out;
+    deflateEnd(&stream);
+
+    if (status != Z_STREAM_END) {
+        free(out);
+        return NULL;
+    }
+    return out;
+}
+
+// 64-bit FNV-1a over the content
+static unsigned long long content_hash(const unsigned char *data, size_t length) {
+    unsigned long long h = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        h = (h ^ data[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+static void write_array(FILE *out, const char *name, const unsigned char *data, size_t length) {
+    fprintf(out, "static const unsigned char %s[%zu] = {", name, length ? length : 1);
+    for (size_t i = 0; i < length; i++) {
+        fprintf(out, "%s0x%02x,", i % 16 ? " " : "\n    ", data[i]);
+    }
+    fprintf(out, "%s};\n\n", length ? "\n" : "0");
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(((const AssetFile *)a)->name, ((const AssetFile *)b)->name);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <output.c> <asset-dir> [files...]\n", argv[0]);
+        return 1;
+    }
+
+    const char *output = argv[1];
+    const char *dir = argv[2];
+    size_t dir_len = strlen(dir);
+    size_t count = (size_t)argc - 3;
+
+    AssetFile *files = calloc(count ? count : 1, sizeof(AssetFile));
+    if (!files) return 1;
+    for (size_t i = 0; i < count; i++) {
+        const char *path = argv[i + 3];
+        files[i].path = path;
+        files[i].name = path;
+        if (strncmp(path, dir, dir_len) == 0 && path[dir_len] == '/') {
+            files[i].name = path + dir_len + 1;
+        }
+    }
+    // Same order whatever order make lists them in
+    qsort(files, count, sizeof(AssetFile), compare_names);
+
+    FILE *out = fopen(output, "w");
+    if (!out) {
+        perror(output);
+        return 1;
+    }
+
+    fprintf(out, "/* Generated by tools/embed_assets.c from %s/ - do not edit */\n\n", dir);
+    fprintf(out, "#include \"http_server.h\"\n\n");
+
+    unsigned long long *hashes = calloc(count ? count : 1, sizeof(unsigned long long));
+    size_t *gzip_lengths = calloc(count ? count : 1, sizeof(size_t));
+    size_t *lengths = calloc(count ? count : 1, sizeof(size_t));
+    if (!hashes || !gzip_lengths || !lengths) return 1;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t length;
+        unsigned char *data = read_file(files[i].path, &length);
+        if (!data) {
+            perror(files[i].path);
+            fclose(out);
+            remove(output);
+            return 1;
+        }
+
+        size_t gzip_length = 0;
+        unsigned char *gzip = gzip_bytes(data, length, &gzip_length);
+        if (gzip && gzip_length >= length) {
+            // Already compressed (images, fonts): not worth sending gzipped
+            free(gzip);
+            gzip = NULL;
+        }
+        if (!gzip) gzip_length = 0;
+
+        char array[32];
+        snprintf(array, sizeof(array), "asset_%zu", i);
+        write_array(out, array, data, length);
+        if (gzip) {
+            snprintf(array, sizeof(array), "asset_%zu_gzip", i);
+            write_array(out, array, gzip, gzip_length);
+        }
+
+        hashes[i] = content_hash(data, length);
+        lengths[i] = length;
+        gzip_lengths[i] = gzip_length;
+        printf("  %-24s %8zu bytes, gzip %8zu\n", files[i].name, length, gzip_length);
+        free(data);
+        free(gzip);
+    }
+
+    fprintf(out, "const EmbeddedAsset embedded_assets[] = {\n");
+    for (size_t i = 0; i < count; i++) {
+        fprintf(out, "    {\"%s\", asset_%zu, %zu, ", files[i].name, i, lengths[i]);
+        if (gzip_lengths[i]) fprintf(out, "asset_%zu_gzip, %zu, ", i, gzip_lengths[i]);
+        else fprintf(out, "NULL, 0, ");
+        fprintf(out, "\"\\\"%016llx\\\"\"},\n", hashes[i]);
+    }
+    if (count == 0) fprintf(out, "    {NULL, NULL, 0, NULL, 0, NULL},\n");
+    fprintf(out, "};\n\n");
+    fprintf(out, "const size_t embedded_asset_count = %zu;\n", count);
+
+    free(hashes);
+    free(gzip_lengths);
+    free(lengths);
+    free(files);
+    if (fclose(out) != 0) {
+        perror(output);
+        remove(output);
+        return 1;
+    }
+    return 0;
+}